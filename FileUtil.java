@@ -4,7 +4,9 @@ import java.awt.*;
 import java.io.File;
 import java.io.FileNotFoundException;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.Scanner;
+import java.util.Set;
 
 /**
  * Utilities to read from file a set of geometric objects.
@@ -18,6 +20,20 @@ public class FileUtil
      * @return array of geometric objects
      */
     public static GeometricObject[] readGeometricObjectsFromFile(String filename)
+    {
+        return readGeometricObjectsFromFile(filename, null);
+    }
+
+    /**
+     * Reads the geometric objects of some layers from given file into an array;
+     * the lines of other layer blocks are passed over without being parsed.
+     * 
+     * @param filename given filename
+     * @param layers names of the layers to read ("" is the unnamed layer in front
+     *               of the first LAYER line), or null to read all layers
+     * @return array of geometric objects
+     */
+    public static GeometricObject[] readGeometricObjectsFromFile(String filename, Set<String> layers)
     {
         ArrayList<GeometricObject> gList = new ArrayList<>();
         
@@ -27,14 +43,27 @@ public class FileUtil
             Scanner in = new Scanner(file);
 
             int[] g;
+            boolean skipping = layers != null && !layers.contains("");
 
             while(in.hasNextLine())
             {
-                String str = in.nextLine();
+                String str = stripLength(in.nextLine());
                 
                 //tokens[0]: object type (POINT, LINE, ...), tokens[1]: parameters
                 String[] tokens = str.split(" ", 2);
 
+                //"LAYER name": the following objects (up to the next LAYER line) belong to layer name
+                if (tokens[0].equals("LAYER"))
+                {
+                    String layer = tokens.length > 1 ? tokens[1].trim() : "";
+                    skipping = layers != null && !layers.contains(layer);
+                    continue;
+                }
+                if (skipping)
+                {
+                    continue;
+                }
+
                 switch (tokens[0])
                 {
                     case "POLYGON":
@@ -131,6 +160,18 @@ public class FileUtil
 
                         break;
 
+                    case "POLYLINE":
+
+                        gList.addAll(parsePolyline(str, in));
+
+                        break;
+
+                    case "MESH":
+
+                        gList.addAll(parseMesh(str, in));
+
+                        break;
+
 
 
                 }
@@ -148,6 +189,20 @@ public class FileUtil
         return gArray;
     }
     
+    /**
+     * Removes the optional "@bytes/lines" token that length-prefixed exports append
+     * to object headers (and exports with layers to LAYER lines).
+     * 
+     * @param str header line
+     * 
+     * @return the header line without the length token
+     */
+    private static String stripLength(String str)
+    {
+        int at = str.lastIndexOf(" @");
+        return at >= 0 ? str.substring(0, at) : str;
+    }
+
     /**
      * Parse the given string into the components of a geometric object; no 
      * validation is performed on the string.
@@ -316,6 +371,127 @@ public class FileUtil
 
     }
 
+    /**
+     * Parse a polyline into one LineSegment per pair of consecutive vertices.
+     * 
+     * @param str header formatted as "POLYLINE numVertices r g b alpha beta",
+     *            followed in the input by numVertices POINT lines
+     * @param in scanner positioned after the header
+     * 
+     * @return the segments of the polyline, all in the style of the header
+     */
+    public static ArrayList<GeometricObject> parsePolyline(String str, Scanner in){
+
+        String[] polylineInfo = str.split(" ", 3);
+
+        int numVertices = Integer.parseInt(polylineInfo[1]);
+        int[] g = parseGeometricObject(polylineInfo[2]);
+
+        Color boundaryColor = new Color(g[0],g[1],g[2],g[3]);
+        int boundaryType = g[4];
+
+        ArrayList<GeometricObject> segments = new ArrayList<>();
+        Point previous = null;
+        for(int i = 0; i < numVertices; i++){
+            Point p = parsePoint(stripLength(in.nextLine()));
+            if(previous != null){
+                LineSegment seg = new LineSegment(previous, p);
+                seg.setBoundaryColor(boundaryColor);
+                seg.setBoundaryType(boundaryType);
+                segments.add(seg);
+            }
+            previous = p;
+        }
+
+        return segments;
+    }
+
+    /**
+     * Parse a shared-vertex mesh into one geometric object per face: a Triangle
+     * for faces with 3 vertices, a Polygon otherwise.
+     * 
+     * @param str header formatted as "MESH numVertices numFaces r g b alpha beta r g b alpha"
+     *            (the interior color, or the whole style, may be left out, as for the C++ reader),
+     *            followed in the input by numVertices lines "x y" and numFaces lines
+     *            "numIndices index index ..."
+     * @param in scanner positioned after the header
+     * 
+     * @return the faces of the mesh, all in the style of the header; none if the header is malformed
+     */
+    public static ArrayList<GeometricObject> parseMesh(String str, Scanner in){
+
+        ArrayList<GeometricObject> faces = new ArrayList<>();
+
+        //tokens: MESH, numVertices, numFaces, then the style
+        String[] meshInfo = stripLength(str).trim().split("\\s+");
+        if(meshInfo.length < 3){
+            System.out.println("Missing vertex or face count of mesh");
+            return faces;
+        }
+        int numVertices = Integer.parseInt(meshInfo[1]);
+        int numFaces = Integer.parseInt(meshInfo[2]);
+
+        int[] g;
+        int numStyle = meshInfo.length - 3;
+        if(numStyle == 0){
+            //default style: black, solid
+            g = new int[]{0, 0, 0, 255, 0, 0, 0, 0, 255};
+        }
+        else if(numStyle == 5 || numStyle == 9){
+            g = parseGeometricObject(String.join(" ", Arrays.copyOfRange(meshInfo, 3, meshInfo.length)));
+            if(numStyle == 5){
+                //the interior takes the boundary color
+                g = new int[]{g[0], g[1], g[2], g[3], g[4], g[0], g[1], g[2], g[3]};
+            }
+        }
+        else{
+            System.out.println("Malformed style of mesh");
+            //skip the vertex and face lines, so that reading continues with the next object
+            for(int i = 0; i < numVertices + numFaces && in.hasNextLine(); i++){
+                in.nextLine();
+            }
+            return faces;
+        }
+
+        Color boundaryColor = new Color(g[0],g[1],g[2],g[3]);
+        int boundaryType = g[4];
+        Color interiorColor = new Color(g[5], g[6], g[7], g[8]);
+
+        //vertex table, shared by the faces
+        Point[] vertices = new Point[numVertices];
+        for(int i = 0; i < numVertices; i++){
+            String[] xy = in.nextLine().trim().split("\\s+");
+            vertices[i] = new Point(Double.parseDouble(xy[0]), Double.parseDouble(xy[1]));
+        }
+
+        for(int i = 0; i < numFaces; i++){
+            String[] face = in.nextLine().trim().split("\\s+");
+            int faceSize = Integer.parseInt(face[0]);
+
+            Point[] points = new Point[faceSize];
+            for(int k = 0; k < faceSize; k++){
+                points[k] = vertices[Integer.parseInt(face[k + 1])];
+            }
+
+            if(faceSize == 3){
+                Triangle tri = new Triangle(points[0], points[1], points[2]);
+                tri.setBoundaryColor(boundaryColor);
+                tri.setBoundaryType(boundaryType);
+                tri.setInteriorColor(interiorColor);
+                faces.add(tri);
+            }
+            else{
+                Polygon polygon = new Polygon(points);
+                polygon.setBoundaryColor(boundaryColor);
+                polygon.setBoundaryType(boundaryType);
+                polygon.setInteriorColor(interiorColor);
+                faces.add(polygon);
+            }
+        }
+
+        return faces;
+    }
+
     public static Polygon parsePolygon(String str, Scanner in){
 
         String[] polygonInfo = str.split(" ", 3);
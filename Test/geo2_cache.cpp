@@ -0,0 +1,546 @@
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "geo2_cache.h"
+#include "geo2_internal.h"
+
+namespace Geo2Util {
+    namespace {
+        namespace fs = std::filesystem;
+        using internal::ByteOrderMark;
+        using internal::mix;
+
+        const char SnapshotMagic[8] = { 'G', 'E', 'O', '2', 'S', 'N', 'A', 'P' };
+        const char SnapshotEnd[8] = { 'G', 'E', 'O', '2', 'E', 'N', 'D', '\0' };
+        const std::uint32_t SnapshotVersion = 2;
+        const char* const SnapshotExtension = ".geo2snap";
+
+        // Files up to this size are hashed completely, larger ones by HashSamples blocks spread over the file
+        const std::uint64_t HashBlockSize = 1 << 16;
+        const std::uint64_t HashSamples = 16;
+
+        std::uint64_t hashBytes(std::uint64_t h, const char* data, std::size_t len) {
+            for (std::size_t i = 0; i < len; ++i) {
+                h = (h ^ (unsigned char)data[i]) * 0x100000001b3ULL; // FNV-1a
+            }
+            return mix(h);
+        }
+
+        // Identity of a source file, compared against the one stored in a snapshot
+        struct SourceKey {
+            std::string path;
+            std::uint64_t size = 0;
+            std::int64_t mtime = 0;
+            std::uint64_t contentHash = 0;
+            std::uint32_t recordTypes = 0;
+            std::uint64_t errorBudget = 0;
+
+            bool operator==(const SourceKey& other) const {
+                return path == other.path && size == other.size && mtime == other.mtime
+                    && contentHash == other.contentHash && recordTypes == other.recordTypes && errorBudget == other.errorBudget;
+            }
+        };
+
+        /**
+         * @brief Hash the content of a file: small files completely, large ones by evenly spaced blocks (plus the last one)
+         */
+        std::uint64_t contentHash(const std::string& filename, std::uint64_t size) {
+            std::ifstream in(filename, std::ios::binary);
+            std::vector<char> block(HashBlockSize);
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            auto hashAt = [&](std::uint64_t offset, std::uint64_t len) {
+                in.seekg((std::streamoff)offset);
+                in.read(block.data(), (std::streamsize)len);
+                h = hashBytes(h, block.data(), (std::size_t)in.gcount());
+            };
+
+            if (size <= HashBlockSize * (HashSamples + 1)) {
+                for (std::uint64_t offset = 0; offset < size; offset += HashBlockSize) {
+                    hashAt(offset, std::min(HashBlockSize, size - offset));
+                }
+            }
+            else {
+                for (std::uint64_t i = 0; i < HashSamples; ++i) {
+                    hashAt((size - HashBlockSize) / HashSamples * i, HashBlockSize);
+                }
+                hashAt(size - HashBlockSize, HashBlockSize);
+            }
+            return h;
+        }
+
+        /**
+         * @brief Identify the current state of a file
+         * @return False if the file does not exist
+         */
+        bool sourceKey(const std::string& filename, const ParseOptions& options, SourceKey& key) {
+            std::error_code ec;
+            const fs::path path = fs::canonical(filename, ec);
+            if (ec) return false;
+            const std::uintmax_t size = fs::file_size(path, ec);
+            if (ec) return false;
+            const fs::file_time_type mtime = fs::last_write_time(path, ec);
+            if (ec) return false;
+
+            key.path = path.string();
+            key.size = (std::uint64_t)size;
+            key.mtime = (std::int64_t)mtime.time_since_epoch().count();
+            key.contentHash = contentHash(key.path, key.size);
+            key.recordTypes = options.recordTypes;
+            key.errorBudget = (std::uint64_t)options.errorBudget;
+            return true;
+        }
+
+        // Buffered writer of the binary snapshot
+        class SnapshotWriter {
+        public:
+            explicit SnapshotWriter(const std::string& filename) : out(filename, std::ios::binary | std::ios::trunc) {}
+
+            template <class T>
+            void put(const T& value) {
+                buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                if (buffer.size() >= (1 << 20)) flush();
+            }
+            void put(const std::string& str) {
+                put((std::uint64_t)str.size());
+                buffer += str;
+            }
+            void put(const Point_2& p) {
+                put(p.x());
+                put(p.y());
+            }
+            template <class Container>
+            void putPoints(const Container& points) {
+                put((std::uint64_t)points.size());
+                for (const Point_2& p : points) put(p);
+            }
+
+            bool finish() {
+                buffer.append(SnapshotEnd, sizeof(SnapshotEnd));
+                flush();
+                out.close();
+                return !out.fail();
+            }
+
+        private:
+            void flush() {
+                out.write(buffer.data(), (std::streamsize)buffer.size());
+                buffer.clear();
+            }
+
+            std::ofstream out;
+            std::string buffer;
+        };
+
+        // Bounds-checked reader of a mapped snapshot; once ok turns false, every read returns 0
+        class SnapshotReader {
+        public:
+            SnapshotReader(const char* first, const char* last) : pos(first), end(last) {}
+
+            template <class T>
+            T get() {
+                T value = T();
+                if (!ok || (std::size_t)(end - pos) < sizeof(T)) {
+                    ok = false;
+                    return value;
+                }
+                std::memcpy(&value, pos, sizeof(T));
+                pos += sizeof(T);
+                return value;
+            }
+            std::string getString() {
+                const std::uint64_t len = count(1);
+                std::string str(pos, (std::size_t)len);
+                pos += len;
+                return str;
+            }
+            Point_2 getPoint() {
+                const double x = get<double>();
+                const double y = get<double>();
+                return Point_2(x, y);
+            }
+            // Read an element count; 0 (and !ok) if the remaining bytes cannot hold that many elements of minBytes each
+            std::uint64_t count(std::size_t minBytes) {
+                const std::uint64_t n = get<std::uint64_t>();
+                if (!ok || n > (std::uint64_t)(end - pos) / minBytes) {
+                    ok = false;
+                    return 0;
+                }
+                return n;
+            }
+            bool atEnd() {
+                const bool complete = ok && (std::size_t)(end - pos) == sizeof(SnapshotEnd)
+                    && std::memcmp(pos, SnapshotEnd, sizeof(SnapshotEnd)) == 0;
+                ok = complete;
+                return complete;
+            }
+
+            bool ok = true;
+
+        private:
+            const char* pos;
+            const char* end;
+        };
+
+        void writeKey(SnapshotWriter& out, const SourceKey& key) {
+            for (char c : SnapshotMagic) out.put(c);
+            out.put(SnapshotVersion);
+            out.put(ByteOrderMark);
+            out.put(key.path);
+            out.put(key.size);
+            out.put(key.mtime);
+            out.put(key.contentHash);
+            out.put(key.recordTypes);
+            out.put(key.errorBudget);
+        }
+
+        bool readKey(SnapshotReader& in, SourceKey& key) {
+            for (char c : SnapshotMagic) {
+                if (in.get<char>() != c) return false;
+            }
+            if (in.get<std::uint32_t>() != SnapshotVersion || in.get<std::uint32_t>() != ByteOrderMark) return false;
+            key.path = in.getString();
+            key.size = in.get<std::uint64_t>();
+            key.mtime = in.get<std::int64_t>();
+            key.contentHash = in.get<std::uint64_t>();
+            key.recordTypes = in.get<std::uint32_t>();
+            key.errorBudget = in.get<std::uint64_t>();
+            return in.ok;
+        }
+
+        /**
+         * @brief Write the report and the objects of a parsed file
+         */
+        void writeObjects(SnapshotWriter& out, const ParseReport& report, const GeometrySet& geometry) {
+            out.put((std::uint64_t)report.records);
+            out.put((std::uint8_t)report.aborted);
+            out.put((std::uint64_t)report.diagnostics.size());
+            for (const ParseDiagnostic& diag : report.diagnostics) {
+                out.put((std::uint64_t)diag.line);
+                out.put(diag.offset);
+                out.put(diag.recordType);
+                out.put(diag.reason);
+            }
+
+            out.putPoints(geometry.points);
+            out.put((std::uint64_t)geometry.segments.size());
+            for (const Segment_2& seg : geometry.segments) {
+                out.put(seg.source());
+                out.put(seg.target());
+            }
+            out.put((std::uint64_t)geometry.circles.size());
+            for (const Circle_2& circ : geometry.circles) {
+                out.put(circ.center());
+                out.put((double)circ.squared_radius());
+            }
+            out.put((std::uint64_t)geometry.triangles.size());
+            for (const Triangle_2& tri : geometry.triangles) {
+                out.put(tri[0]);
+                out.put(tri[1]);
+                out.put(tri[2]);
+            }
+            out.put((std::uint64_t)geometry.rectangles.size());
+            for (const Iso_rectangle_2& rect : geometry.rectangles) {
+                out.put(rect.min());
+                out.put(rect.max());
+            }
+            out.put((std::uint64_t)geometry.polygons.size());
+            for (const Polygon_2& poly : geometry.polygons) {
+                out.putPoints(poly);
+            }
+            out.put((std::uint64_t)geometry.polygonsWithHoles.size());
+            for (const Polygon_with_holes_2& poly_w_h : geometry.polygonsWithHoles) {
+                out.putPoints(poly_w_h.outer_boundary());
+                out.put((std::uint64_t)poly_w_h.number_of_holes());
+                for (auto it = poly_w_h.holes_begin(); it != poly_w_h.holes_end(); ++it) {
+                    out.putPoints(*it);
+                }
+            }
+            out.put((std::uint64_t)geometry.lines.size());
+            for (const Line_2& line : geometry.lines) {
+                out.put((double)line.a());
+                out.put((double)line.b());
+                out.put((double)line.c());
+            }
+            out.put((std::uint64_t)geometry.rays.size());
+            for (const Ray_2& ray : geometry.rays) {
+                out.put(ray.source());
+                out.put(ray.point(1));
+            }
+            out.put((std::uint64_t)geometry.meshes.size());
+            for (const Mesh_2& mesh : geometry.meshes) {
+                out.putPoints(mesh.vertices);
+                out.put((std::uint64_t)mesh.faceSizes.size());
+                for (std::size_t size : mesh.faceSizes) out.put((std::uint64_t)size);
+                out.put((std::uint64_t)mesh.indices.size());
+                for (std::size_t index : mesh.indices) out.put((std::uint64_t)index);
+            }
+            out.put((std::uint64_t)geometry.polylines.size());
+            for (const Polyline_2& polyline : geometry.polylines) {
+                out.putPoints(polyline.vertices);
+            }
+        }
+
+        Polygon_2 readPolygon(SnapshotReader& in) {
+            Polygon_2 poly;
+            const std::uint64_t n = in.count(2 * sizeof(double));
+            for (std::uint64_t i = 0; i < n; ++i) poly.push_back(in.getPoint());
+            return poly;
+        }
+
+        /**
+         * @brief Read the report and the objects written by writeObjects
+         * @return False if the snapshot is truncated or corrupt
+         */
+        bool readObjects(SnapshotReader& in, ParseReport& report, GeometrySet& geometry) {
+            const std::size_t PointBytes = 2 * sizeof(double);
+            ParseReport snapshot_report;
+            snapshot_report.records = (std::size_t)in.get<std::uint64_t>();
+            snapshot_report.aborted = in.get<std::uint8_t>() != 0;
+            snapshot_report.diagnostics.resize((std::size_t)in.count(4 * sizeof(std::uint64_t)));
+            for (ParseDiagnostic& diag : snapshot_report.diagnostics) {
+                diag.line = (std::size_t)in.get<std::uint64_t>();
+                diag.offset = in.get<std::uint64_t>();
+                diag.recordType = in.getString();
+                diag.reason = in.getString();
+            }
+
+            std::uint64_t n = in.count(PointBytes);
+            geometry.points.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) geometry.points.push_back(in.getPoint());
+
+            n = in.count(2 * PointBytes);
+            geometry.segments.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const Point_2 source = in.getPoint();
+                geometry.segments.push_back(Segment_2(source, in.getPoint()));
+            }
+            n = in.count(3 * sizeof(double));
+            geometry.circles.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const Point_2 center = in.getPoint();
+                geometry.circles.push_back(Circle_2(center, in.get<double>()));
+            }
+            n = in.count(3 * PointBytes);
+            geometry.triangles.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const Point_2 p = in.getPoint();
+                const Point_2 q = in.getPoint();
+                geometry.triangles.push_back(Triangle_2(p, q, in.getPoint()));
+            }
+            n = in.count(2 * PointBytes);
+            geometry.rectangles.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const Point_2 min = in.getPoint();
+                geometry.rectangles.push_back(Iso_rectangle_2(min, in.getPoint()));
+            }
+            n = in.count(sizeof(std::uint64_t));
+            geometry.polygons.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) geometry.polygons.push_back(readPolygon(in));
+
+            n = in.count(2 * sizeof(std::uint64_t));
+            geometry.polygonsWithHoles.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                Polygon_with_holes_2 poly_w_h(readPolygon(in));
+                const std::uint64_t num_holes = in.count(sizeof(std::uint64_t));
+                for (std::uint64_t hole = 0; hole < num_holes; ++hole) poly_w_h.add_hole(readPolygon(in));
+                geometry.polygonsWithHoles.push_back(poly_w_h);
+            }
+            n = in.count(3 * sizeof(double));
+            geometry.lines.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const double a = in.get<double>();
+                const double b = in.get<double>();
+                geometry.lines.push_back(Line_2(a, b, in.get<double>()));
+            }
+            n = in.count(2 * PointBytes);
+            geometry.rays.reserve((std::size_t)n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const Point_2 source = in.getPoint();
+                geometry.rays.push_back(Ray_2(source, in.getPoint()));
+            }
+            n = in.count(3 * sizeof(std::uint64_t));
+            geometry.meshes.resize((std::size_t)n);
+            for (Mesh_2& mesh : geometry.meshes) {
+                std::uint64_t count = in.count(PointBytes);
+                mesh.vertices.reserve((std::size_t)count);
+                for (std::uint64_t i = 0; i < count; ++i) mesh.vertices.push_back(in.getPoint());
+                count = in.count(sizeof(std::uint64_t));
+                mesh.faceSizes.reserve((std::size_t)count);
+                for (std::uint64_t i = 0; i < count; ++i) mesh.faceSizes.push_back((std::size_t)in.get<std::uint64_t>());
+                count = in.count(sizeof(std::uint64_t));
+                mesh.indices.reserve((std::size_t)count);
+                for (std::uint64_t i = 0; i < count; ++i) mesh.indices.push_back((std::size_t)in.get<std::uint64_t>());
+            }
+            n = in.count(sizeof(std::uint64_t));
+            geometry.polylines.resize((std::size_t)n);
+            for (Polyline_2& polyline : geometry.polylines) {
+                const std::uint64_t count = in.count(PointBytes);
+                polyline.vertices.reserve((std::size_t)count);
+                for (std::uint64_t i = 0; i < count; ++i) polyline.vertices.push_back(in.getPoint());
+            }
+
+            if (!in.atEnd()) return false;
+            report.records += snapshot_report.records;
+            report.aborted = report.aborted || snapshot_report.aborted;
+            report.diagnostics.insert(report.diagnostics.end(),
+                snapshot_report.diagnostics.begin(), snapshot_report.diagnostics.end());
+            return true;
+        }
+
+        /**
+         * @brief Load a snapshot if it exists and belongs to the given source state
+         * @return False on a missing, stale or corrupt snapshot (geometry is then left empty)
+         */
+        bool loadSnapshot(const std::string& snapshot, const SourceKey& key, ParseReport& report, GeometrySet& geometry) {
+            std::error_code ec;
+            if (!fs::is_regular_file(snapshot, ec) || fs::file_size(snapshot, ec) == 0) return false;
+
+            try {
+                using namespace boost::interprocess;
+                const file_mapping file(snapshot.c_str(), read_only);
+                const mapped_region region(file, read_only);
+                const char* data = static_cast<const char*>(region.get_address());
+                SnapshotReader in(data, data + region.get_size());
+
+                SourceKey stored;
+                if (!readKey(in, stored) || !(stored == key)) return false;
+                if (!readObjects(in, report, geometry)) {
+                    geometry = GeometrySet();
+                    return false;
+                }
+            }
+            catch (const boost::interprocess::interprocess_exception&) {
+                return false;
+            }
+            fs::last_write_time(snapshot, fs::file_time_type::clock::now(), ec); // recently used, evicted last
+            return true;
+        }
+    }
+
+    /**
+     * @brief Create a cache; the cache directory is created on the first snapshot written
+     * @param options Location and size limit of the snapshots
+     */
+    GeometryCache::GeometryCache(const CacheOptions& options) : options(options) {}
+
+    /**
+     * @brief Retrieve the objects of all types from target file, from its snapshot if there is an up-to-date one.
+     * Otherwise the file is parsed (like getGeometry) and a new snapshot is written; the diagnostics of the parse
+     * are stored with the snapshot and reported again by later loads.
+     * @param filename Target file
+     * @param options Parse options; part of the cache key, so that differently filtered imports do not mix
+     * @param report Receives the diagnostics
+     * @return All objects of the file, grouped by type
+     */
+    GeometrySet GeometryCache::load(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        lastHit = false;
+        SourceKey key;
+        if (options.pendingTail || options.filter.active() || !options.layers.empty() || !sourceKey(filename, options, key)) {
+            return getGeometry(filename, options, report); // growing, filtered or missing file: nothing to cache
+        }
+
+        const std::string snapshot = snapshotPath(filename);
+        GeometrySet geometry;
+        if (loadSnapshot(snapshot, key, report, geometry)) {
+            lastHit = true;
+            return geometry;
+        }
+
+        ParseReport parse_report;
+        geometry = getGeometry(filename, options, parse_report);
+        report.records += parse_report.records;
+        report.aborted = report.aborted || parse_report.aborted;
+        report.diagnostics.insert(report.diagnostics.end(), parse_report.diagnostics.begin(), parse_report.diagnostics.end());
+
+        // The file may have changed while it was parsed; such a result is not cached
+        SourceKey parsed_key;
+        if (!sourceKey(filename, options, parsed_key) || !(parsed_key == key)) return geometry;
+
+        std::error_code ec;
+        if (!this->options.directory.empty()) fs::create_directories(this->options.directory, ec);
+
+        // Written under a temporary name and renamed, so that readers never see a partial snapshot
+        const std::string temporary = snapshot + ".tmp"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        SnapshotWriter out(temporary);
+        writeKey(out, key);
+        writeObjects(out, parse_report, geometry);
+        const bool written = out.finish();
+        const std::uintmax_t size = fs::file_size(temporary, ec);
+        if (written && !ec && size <= this->options.maxBytes) {
+            fs::rename(temporary, snapshot, ec);
+        }
+        fs::remove(temporary, ec);
+
+        if (!this->options.directory.empty()) trim();
+        return geometry;
+    }
+
+    /**
+     * @brief Path of the snapshot of a file: "<file>.geo2snap", or a name derived from the absolute path in the cache directory
+     * @param filename Target file
+     * @return Path of the snapshot (which may not exist)
+     */
+    std::string GeometryCache::snapshotPath(const std::string& filename) const {
+        if (options.directory.empty()) return filename + SnapshotExtension;
+
+        std::error_code ec;
+        fs::path path = fs::weakly_canonical(filename, ec);
+        if (ec) path = fs::absolute(filename);
+        const std::string path_str = path.string();
+        char name[17];
+        const std::uint64_t h = hashBytes(0xcbf29ce484222325ULL, path_str.data(), path_str.size());
+        for (int i = 0; i < 16; ++i) name[i] = "0123456789abcdef"[(h >> (60 - 4 * i)) & 0xf];
+        name[16] = '\0';
+        return (fs::path(options.directory) / (std::string(name) + SnapshotExtension)).string();
+    }
+
+    /**
+     * @brief Remove the snapshot of a file, e.g. after the file has been rewritten within the resolution of its modification time
+     * @param filename Target file
+     */
+    void GeometryCache::invalidate(const std::string& filename) {
+        std::error_code ec;
+        fs::remove(snapshotPath(filename), ec);
+    }
+
+    /**
+     * @brief Remove the least recently used snapshots of the cache directory until their total size is at most maxBytes
+     */
+    void GeometryCache::trim() {
+        if (options.directory.empty()) return;
+
+        struct Entry {
+            fs::path path;
+            fs::file_time_type used;
+            std::uint64_t size;
+        };
+        std::vector<Entry> entries;
+        std::uint64_t total = 0;
+        std::error_code ec;
+        for (fs::directory_iterator it(options.directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() != SnapshotExtension) continue;
+            std::error_code entry_ec;
+            const std::uintmax_t size = it->file_size(entry_ec);
+            const fs::file_time_type used = it->last_write_time(entry_ec);
+            if (entry_ec) continue;
+            entries.push_back({ it->path(), used, (std::uint64_t)size });
+            total += size;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+        for (const Entry& entry : entries) {
+            if (total <= options.maxBytes) break;
+            if (fs::remove(entry.path, ec)) total -= entry.size;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    struct CacheOptions {
+        // Directory of the snapshots; empty (default) stores "<file>.geo2snap" next to each imported file
+        std::string directory;
+        // Max. total size of the snapshots in directory; the least recently used ones are evicted first.
+        // Without a directory, snapshots larger than this are not written.
+        std::uint64_t maxBytes = (std::uint64_t)4 << 30;
+    };
+
+    /**
+     * Opt-in cache of parsed files. The first import of a file parses the text and writes a binary
+     * snapshot of the objects; later imports memory-map the snapshot instead of parsing the text again.
+     * A snapshot is only used while the path, size, modification time and content hash of the file
+     * (and the parse options) are the same as when it was written. Large files are hashed by sampled
+     * blocks only, so a same-size edit between them that restores the modification time goes unnoticed.
+     */
+    class GeometryCache {
+    public:
+        explicit GeometryCache(const CacheOptions& options = CacheOptions());
+
+        // Import all objects of a file, from its snapshot if it is up to date (see getGeometry)
+        GeometrySet load(const std::string& filename, const ParseOptions& options, ParseReport& report);
+        // True if the last load() was served from a snapshot
+        bool hit() const { return lastHit; }
+
+        // Path of the snapshot of a file
+        std::string snapshotPath(const std::string& filename) const;
+        // Remove the snapshot of a file
+        void invalidate(const std::string& filename);
+        // Evict the least recently used snapshots of the cache directory until they fit into maxBytes
+        void trim();
+
+    private:
+        CacheOptions options;
+        bool lastHit = false;
+    };
+}
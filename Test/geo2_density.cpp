@@ -0,0 +1,225 @@
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "geo2_density.h"
+#include "geo2_internal.h"
+
+namespace Geo2Util {
+    namespace {
+        // Min. # of points binned per thread
+        const std::size_t MinPointsPerThread = 1 << 16;
+
+        /**
+         * @brief Create a grid of zero counts; a degenerate extent is widened to 1 unit
+         */
+        DensityGrid emptyGrid(double xmin, double ymin, double xmax, double ymax, std::size_t columns, std::size_t rows) {
+            DensityGrid grid;
+            grid.xmin = xmin;
+            grid.ymin = ymin;
+            grid.xmax = xmax > xmin ? xmax : xmin + 1;
+            grid.ymax = ymax > ymin ? ymax : ymin + 1;
+            grid.columns = std::max<std::size_t>(columns, 1);
+            grid.rows = std::max<std::size_t>(rows, 1);
+            grid.counts.assign(grid.columns * grid.rows, 0);
+            return grid;
+        }
+
+        bool hasExtent(const Iso_rectangle_2& bounds) {
+            return bounds.xmax() > bounds.xmin() && bounds.ymax() > bounds.ymin();
+        }
+
+        /**
+         * @brief Index of the cell containing (x, y); points on the max. boundary belong to the last cell
+         * @return The cell index, or counts.size() if the point is outside of the grid
+         */
+        std::size_t cellOf(const DensityGrid& grid, double x, double y) {
+            if (!(x >= grid.xmin && x <= grid.xmax && y >= grid.ymin && y <= grid.ymax)) return grid.counts.size();
+            const std::size_t column = std::min(grid.columns - 1,
+                (std::size_t)((x - grid.xmin) / (grid.xmax - grid.xmin) * grid.columns));
+            const std::size_t row = std::min(grid.rows - 1,
+                (std::size_t)((y - grid.ymin) / (grid.ymax - grid.ymin) * grid.rows));
+            return row * grid.columns + column;
+        }
+
+        unsigned threadCount(const DensityGridOptions& options, std::size_t numPoints) {
+            return internal::threadCount(options.threads, numPoints, MinPointsPerThread);
+        }
+
+        using internal::parallelFor;
+    }
+
+    /**
+     * @brief Count the points falling into each cell of a regular grid; binning runs in parallel on large inputs
+     * @param points Point_2 objects
+     * @param options Grid resolution, extent and # of threads
+     * @return The point counts of the grid cells
+     */
+    DensityGrid densityGrid(const std::vector<Point_2>& points, const DensityGridOptions& options) {
+        const unsigned num_threads = threadCount(options, points.size());
+
+        double xmin = options.bounds.xmin(), ymin = options.bounds.ymin();
+        double xmax = options.bounds.xmax(), ymax = options.bounds.ymax();
+        if (!hasExtent(options.bounds) && !points.empty()) {
+            std::vector<CGAL::Bbox_2> boxes(num_threads, points[0].bbox());
+            parallelFor(num_threads, points.size(), [&](unsigned t, std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) boxes[t] = boxes[t] + points[i].bbox();
+            });
+            for (const CGAL::Bbox_2& box : boxes) boxes[0] = boxes[0] + box;
+            xmin = boxes[0].xmin(); ymin = boxes[0].ymin();
+            xmax = boxes[0].xmax(); ymax = boxes[0].ymax();
+        }
+        DensityGrid grid = emptyGrid(xmin, ymin, xmax, ymax, options.columns, options.rows);
+
+        // Every thread bins into its own grid; the grids are summed up cell range by cell range
+        std::vector<std::vector<std::uint64_t>> partial(num_threads);
+        parallelFor(num_threads, points.size(), [&](unsigned t, std::size_t first, std::size_t last) {
+            std::vector<std::uint64_t>& counts = partial[t];
+            counts.assign(grid.counts.size() + 1, 0); // + 1: bin of the points outside of the grid
+            for (std::size_t i = first; i < last; ++i) {
+                ++counts[cellOf(grid, points[i].x(), points[i].y())];
+            }
+        });
+        parallelFor(num_threads, grid.counts.size(), [&](unsigned, std::size_t first, std::size_t last) {
+            for (const std::vector<std::uint64_t>& counts : partial) {
+                for (std::size_t cell = first; cell < last; ++cell) grid.counts[cell] += counts[cell];
+            }
+        });
+        return grid;
+    }
+
+    /**
+     * @brief Count the POINT objects of a file into a regular grid while the file is parsed
+     * (without grid bounds the file is read twice: once for the bounding box, once for the counts)
+     * @param filename Target file
+     * @param options Grid resolution and extent
+     * @param report Receives the diagnostics
+     * @return The point counts of the grid cells
+     */
+    DensityGrid densityGrid(const std::string& filename, const DensityGridOptions& options, ParseReport& report) {
+        ParseOptions parse_options;
+        parse_options.recordTypes = typeBit(RecordType::Point);
+        Record rec;
+
+        double xmin = options.bounds.xmin(), ymin = options.bounds.ymin();
+        double xmax = options.bounds.xmax(), ymax = options.bounds.ymax();
+        if (!hasExtent(options.bounds)) {
+            xmin = ymin = std::numeric_limits<double>::max();
+            xmax = ymax = std::numeric_limits<double>::lowest();
+            std::ifstream in(filename, std::ios::binary);
+            ParseReport bounds_report; // the diagnostics are reported by the second pass
+            RecordReader reader(in, parse_options, bounds_report);
+            while (reader.next(rec)) {
+                if (rec.type != RecordType::Point) continue;
+                xmin = std::min(xmin, rec.values[0]); xmax = std::max(xmax, rec.values[0]);
+                ymin = std::min(ymin, rec.values[1]); ymax = std::max(ymax, rec.values[1]);
+            }
+            if (xmin > xmax) xmin = ymin = xmax = ymax = 0;
+        }
+        DensityGrid grid = emptyGrid(xmin, ymin, xmax, ymax, options.columns, options.rows);
+
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            report.diagnostics.push_back({ 0, 0, "", "cannot open file '" + filename + "'" });
+            return grid;
+        }
+        RecordReader reader(in, parse_options, report);
+        while (reader.next(rec)) {
+            if (rec.type != RecordType::Point) continue;
+            const std::size_t cell = cellOf(grid, rec.values[0], rec.values[1]);
+            if (cell < grid.counts.size()) ++grid.counts[cell];
+        }
+        return grid;
+    }
+
+    /**
+     * @brief Build coarser versions of a grid by summing up 2x2 cells, down to at most levels grids (or a 1x1 grid)
+     * @param grid Finest grid (level 0)
+     * @param levels Max. # of levels
+     * @return The grids from finest to coarsest
+     */
+    std::vector<DensityGrid> densityPyramid(const DensityGrid& grid, std::size_t levels) {
+        std::vector<DensityGrid> pyramid;
+        if (levels == 0) return pyramid;
+        pyramid.push_back(grid);
+
+        while (pyramid.size() < levels && (pyramid.back().columns > 1 || pyramid.back().rows > 1)) {
+            const DensityGrid& fine = pyramid.back();
+            const double cell_width = (fine.xmax - fine.xmin) / fine.columns;
+            const double cell_height = (fine.ymax - fine.ymin) / fine.rows;
+            const std::size_t columns = (fine.columns + 1) / 2;
+            const std::size_t rows = (fine.rows + 1) / 2;
+
+            DensityGrid coarse = emptyGrid(fine.xmin, fine.ymin,
+                fine.xmin + 2 * cell_width * columns, fine.ymin + 2 * cell_height * rows, columns, rows);
+            for (std::size_t row = 0; row < fine.rows; ++row) {
+                for (std::size_t column = 0; column < fine.columns; ++column) {
+                    coarse.counts[(row / 2) * columns + column / 2] += fine.count(column, row);
+                }
+            }
+            pyramid.push_back(coarse);
+        }
+        return pyramid;
+    }
+
+    /**
+     * @brief Convert a density grid to RECTANGLE objects, whose colors are mapped from the cell counts.
+     * Adjacent cells of a row that map to the same color are merged into one rectangle.
+     * @param grid Density grid
+     * @param style Color ramp of the counts
+     * @return String representations of the rectangles
+     */
+    std::vector<std::string> toStrings(const DensityGrid& grid, const DensityStyle& style) {
+        std::vector<std::string> rects;
+        if (grid.counts.empty()) return rects;
+
+        const std::uint64_t max_count = *std::max_element(grid.counts.begin(), grid.counts.end());
+        const std::size_t steps = std::max<std::size_t>(style.colorSteps, 1);
+        const std::size_t empty_step = steps; // step index of empty cells
+
+        auto stepOf = [&](std::uint64_t count) -> std::size_t {
+            if (count == 0) return empty_step;
+            if (max_count <= 1) return steps - 1;
+            const double t = style.logScale
+                ? std::log((double)count) / std::log((double)max_count)
+                : (double)(count - 1) / (double)(max_count - 1);
+            return (std::size_t)std::lround(t * (steps - 1));
+        };
+        auto colorOf = [&](std::size_t step) -> Color {
+            if (step == empty_step) return TransparentWhite;
+            const double t = steps > 1 ? (double)step / (steps - 1) : 1.0;
+            auto lerp = [t](short a, short b) { return (short)std::lround(a + t * (b - a)); };
+            return {
+                lerp(style.lowColor.r, style.highColor.r),
+                lerp(style.lowColor.g, style.highColor.g),
+                lerp(style.lowColor.b, style.highColor.b),
+                lerp(style.lowColor.trans, style.highColor.trans)
+            };
+        };
+
+        const double cell_width = (grid.xmax - grid.xmin) / grid.columns;
+        const double cell_height = (grid.ymax - grid.ymin) / grid.rows;
+        for (std::size_t row = 0; row < grid.rows; ++row) {
+            std::size_t column = 0;
+            while (column < grid.columns) {
+                const std::size_t step = stepOf(grid.count(column, row));
+                std::size_t end = column + 1;
+                while (end < grid.columns && stepOf(grid.count(end, row)) == step) ++end;
+
+                if (step != empty_step || !style.skipEmpty) {
+                    const Color color = colorOf(step);
+                    const Iso_rectangle_2 rect(
+                        Point_2(grid.xmin + column * cell_width, grid.ymin + row * cell_height),
+                        Point_2(grid.xmin + end * cell_width, grid.ymin + (row + 1) * cell_height)
+                    );
+                    rects.push_back(toString(rect, color, BoundaryType::Solid, color));
+                }
+                column = end;
+            }
+        }
+        return rects;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    struct DensityGridOptions {
+        std::size_t columns = 256;
+        std::size_t rows = 256;
+        // Grid extent; when empty (default), the bounding box of the points is used
+        Iso_rectangle_2 bounds = Iso_rectangle_2(Point_2(0, 0), Point_2(0, 0));
+        // # of binning threads; 0 uses all hardware threads
+        unsigned threads = 0;
+    };
+
+    // Visual setting of an exported density grid
+    struct DensityStyle {
+        Color lowColor = { 255, 255, 204, 255 };    // color of a cell with 1 point
+        Color highColor = { 189, 0, 38, 255 };      // color of the fullest cell
+        bool logScale = true;                       // map log(count) instead of count to the color ramp
+        std::size_t colorSteps = 64;                // # of distinct colors; adjacent cells of equal color are merged
+        bool skipEmpty = true;                      // do not export cells without points
+    };
+
+    // Point counts of the cells of a regular grid, row after row starting at (xmin, ymin)
+    struct DensityGrid {
+        double xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+        std::size_t columns = 0;
+        std::size_t rows = 0;
+        std::vector<std::uint64_t> counts;
+
+        std::uint64_t count(std::size_t column, std::size_t row) const { return counts[row * columns + column]; }
+    };
+
+    // Bin points into a grid (in parallel)
+    DensityGrid densityGrid(const std::vector<Point_2>& points, const DensityGridOptions& options = DensityGridOptions());
+    // Bin the points of a file while they are parsed, without materializing them
+    DensityGrid densityGrid(const std::string& filename, const DensityGridOptions& options, ParseReport& report);
+    // Multi-resolution pyramid: level 0 is grid, every further level halves the resolution
+    std::vector<DensityGrid> densityPyramid(const DensityGrid& grid, std::size_t levels);
+
+    // Export the cells of a grid as RECTANGLE objects colored by their count
+    std::vector<std::string> toStrings(const DensityGrid& grid, const DensityStyle& style = DensityStyle());
+}
@@ -0,0 +1,615 @@
+#include <string>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "geo2_export.h"
+#include "geo2_internal.h"
+
+namespace Geo2Util {
+    /**
+     * Distinct objects seen recently, most recently seen first.
+     * The object text is only kept when duplicates are counted, since the object is then written on eviction.
+     * Objects with equal keys are only duplicates if their snapped values (canonical) are equal, too.
+     */
+    struct Deduplicator {
+        struct Entry {
+            std::uint64_t key;
+            std::string canonical;
+            std::size_t count;
+            std::string text;
+            std::uint64_t id;
+            std::size_t layer;
+        };
+        std::list<Entry> recent;
+        std::unordered_multimap<std::uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    /**
+     * Segments held back for merging into polylines, grouped by layer and style (boundary color and type),
+     * with their original positions.
+     */
+    struct SegmentChainer {
+        typedef std::tuple<std::size_t, short, short, short, short, short> StyleKey;
+        struct Group {
+            std::vector<Segment_2> segments;
+            std::vector<std::uint64_t> ids;
+        };
+        std::map<StyleKey, Group> groups;
+
+        /**
+         * @brief Hold an object if it is a single well-formed LINE_SEGMENT
+         * @param id Original position of the object
+         * @return false if the object is something else (and has to be written as it is)
+         */
+        bool add(const std::string& geo2_Object, std::uint64_t id, std::size_t layer) {
+            MemoryBuffer buffer(geo2_Object.data(), geo2_Object.data() + geo2_Object.size());
+            std::istream in(&buffer);
+            ParseOptions parse_options;
+            parse_options.errorBudget = 0;
+            ParseReport report;
+            RecordReader reader(in, parse_options, report);
+            Record rec, extra;
+            if (!reader.next(rec) || rec.type != RecordType::Segment || reader.next(extra) || !report.diagnostics.empty()) {
+                return false;
+            }
+
+            const Color& c = rec.style.boundaryColor;
+            Group& group = groups[StyleKey(layer, c.r, c.g, c.b, c.trans, (short)rec.style.boundaryType)];
+            group.segments.push_back(
+                Segment_2(Point_2(rec.points[0].x, rec.points[0].y), Point_2(rec.points[1].x, rec.points[1].y))
+            );
+            group.ids.push_back(id);
+            return true;
+        }
+    };
+
+    namespace {
+        using internal::mix;
+
+        struct Hasher {
+            double tolerance;
+            std::string* canonical;     // receives the hashed values, if not null
+            std::uint64_t h = 0x243f6a8885a308d3ULL;
+
+            void add(std::uint64_t v) {
+                h = mix(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+                if (canonical) canonical->append(reinterpret_cast<const char*>(&v), sizeof(v));
+            }
+            void add(const double v) {
+                if (tolerance > 0) {
+                    add((std::uint64_t)std::llround(v / tolerance));
+                }
+                else {
+                    const double normalized = v + 0.0; // -0.0 == 0.0
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &normalized, sizeof(bits));
+                    add(bits);
+                }
+            }
+            void add(const Color& c) {
+                add((std::uint64_t)(std::uint16_t)c.r << 48 | (std::uint64_t)(std::uint16_t)c.g << 32
+                    | (std::uint64_t)(std::uint16_t)c.b << 16 | (std::uint64_t)(std::uint16_t)c.trans);
+            }
+            void add(const Style& s) {
+                add(s.boundaryColor);
+                add((std::uint64_t)s.boundaryType);
+                add(s.interiorColor);
+            }
+        };
+    }
+
+    namespace {
+        std::size_t countAt(const std::vector<std::string_view>& tokens, std::size_t i) {
+            std::size_t count = 0;
+            if (i < tokens.size()) std::from_chars(tokens[i].data(), tokens[i].data() + tokens[i].size(), count);
+            return count;
+        }
+
+        /**
+         * @brief Append the record whose header is lines[i] to out, with the length token added to its header(s)
+         * @param lines Lines of an object
+         * @param i Index of the header line
+         * @param out Output text
+         * @return Index of the line after the record
+         */
+        std::size_t appendWithLength(const std::vector<std::string_view>& lines, std::size_t i, std::string& out) {
+            std::string_view header = lines[i];
+            std::vector<std::string_view> tokens;
+            splitTokens(header, tokens);
+            if (tokens.size() > 1 && tokens.back()[0] == '@') {
+                // Already length-prefixed; the length is recomputed
+                header = header.substr(0, tokens[tokens.size() - 2].data() + tokens[tokens.size() - 2].size() - header.data());
+                tokens.pop_back();
+            }
+
+            std::string details;
+            std::size_t next = i + 1;
+            const RecordType type = tokens.empty() ? RecordType::Unknown : toRecordType(tokens[0]);
+            if (type == RecordType::PolygonWithHoles) {
+                const std::size_t num_rings = countAt(tokens, 1) + 1;
+                for (std::size_t ring = 0; ring < num_rings && next < lines.size(); ++ring) {
+                    next = appendWithLength(lines, next, details);
+                }
+            }
+            else {
+                std::size_t num_lines = detailLength(type);
+                if (type == RecordType::Polygon || type == RecordType::Polyline) {
+                    num_lines = countAt(tokens, 1);
+                }
+                else if (type == RecordType::Mesh) {
+                    num_lines = countAt(tokens, 1) + countAt(tokens, 2);
+                }
+                for (std::size_t line = 0; line < num_lines && next < lines.size(); ++line, ++next) {
+                    details.append(lines[next].data(), lines[next].size());
+                    details += '\n';
+                }
+            }
+
+            out.append(header.data(), header.size());
+            if (type != RecordType::Unknown) {
+                out += " @" + std::to_string(details.size()) + "/" + std::to_string(next - i - 1);
+            }
+            out += '\n';
+            out += details;
+            return next;
+        }
+    }
+
+    /**
+     * @brief Append "@bytes/lines" to every object header of a string representation, e.g. "POINT ... @0/0".
+     * bytes/lines is the size of the detail lines following the header (nested records of a POLYGON_WITH_HOLES included).
+     * @param geo2_Object String representation of a 2D geometry object
+     * @return The length-prefixed representation, each line terminated by a newline
+     */
+    std::string withLengths(const std::string& geo2_Object) {
+        std::vector<std::string_view> lines;
+        std::string_view text(geo2_Object);
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (!line.empty()) lines.push_back(line);
+            pos = end + 1;
+        }
+
+        std::string out;
+        out.reserve(geo2_Object.size() + 16 * lines.size());
+        std::size_t i = 0;
+        while (i < lines.size()) {
+            i = appendWithLength(lines, i, out);
+        }
+        return out;
+    }
+
+    namespace {
+        /**
+         * @brief Hash a record like hashRecord, and append the hashed (snapped) values to canonical, if not null:
+         * two records are equal after snapping if and only if they append the same bytes
+         */
+        std::uint64_t hashSnapped(const Record& rec, double tolerance, std::string* canonical) {
+            Hasher hasher{ tolerance, canonical };
+            hasher.add((std::uint64_t)rec.type);
+            hasher.add(rec.style);
+            hasher.add((std::uint64_t)rec.values.size());
+            for (double v : rec.values) hasher.add(v);
+            hasher.add((std::uint64_t)rec.points.size());
+            for (const RawPoint& p : rec.points) {
+                hasher.add(p.x);
+                hasher.add(p.y);
+            }
+            hasher.add((std::uint64_t)rec.rings.size());
+            for (const Ring& ring : rec.rings) {
+                hasher.add((std::uint64_t)ring.size);
+                hasher.add(ring.style);
+            }
+            hasher.add((std::uint64_t)rec.indices.size());
+            for (std::size_t i : rec.indices) hasher.add((std::uint64_t)i);
+            hasher.add((std::uint64_t)rec.faceSizes.size());
+            for (std::size_t n : rec.faceSizes) hasher.add((std::uint64_t)n);
+            return hasher.h;
+        }
+    }
+
+    /**
+     * @brief Hash the type, style and geometry of a record; coordinates are snapped to a grid of size tolerance first
+     * @param rec Parsed record
+     * @param tolerance Grid size of the snapping, 0 for exact coordinates
+     * @return 64-bit hash of the record
+     */
+    std::uint64_t hashRecord(const Record& rec, double tolerance) {
+        return hashSnapped(rec, tolerance, nullptr);
+    }
+
+    namespace {
+        using internal::parallelFor;
+
+        // Min. # of objects per thread computing curve keys or bounding boxes
+        const std::size_t MinObjectsPerThread = 1 << 14;
+        // Room left on a LAYER line for the length of its block: "@" + 20 digits + "/" + 20 digits
+        const std::size_t LayerLengthWidth = 41;
+
+        unsigned threadCount(unsigned threads, std::size_t size) {
+            return internal::threadCount(threads, size, MinObjectsPerThread);
+        }
+
+        /**
+         * @brief Bounding box of all records of a string representation
+         * @return false if it has no bounded record or does not parse
+         */
+        bool objectBounds(const std::string& geo2_Object, CGAL::Bbox_2& box) {
+            MemoryBuffer buffer(geo2_Object.data(), geo2_Object.data() + geo2_Object.size());
+            std::istream in(&buffer);
+            ParseOptions parse_options;
+            parse_options.errorBudget = 0;
+            ParseReport report;
+            RecordReader reader(in, parse_options, report);
+            Record rec;
+            bool bounded = false;
+            CGAL::Bbox_2 rec_box;
+            while (reader.next(rec)) {
+                if (!bboxOf(rec, rec_box)) continue;
+                box = bounded ? box + rec_box : rec_box;
+                bounded = true;
+            }
+            return bounded && report.diagnostics.empty();
+        }
+
+        // Position of a grid cell along the Hilbert curve over a 2^32 x 2^32 grid
+        std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y) {
+            std::uint64_t d = 0;
+            for (std::uint32_t s = 1u << 31; s > 0; s >>= 1) {
+                const std::uint32_t rx = (x & s) ? 1 : 0;
+                const std::uint32_t ry = (y & s) ? 1 : 0;
+                d += (std::uint64_t)s * s * ((3 * rx) ^ ry);
+                // Rotate the quadrant, so that the curve continues in the sub-square
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = ~x;
+                        y = ~y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return d;
+        }
+
+        // Position of a grid cell along the Morton (Z-order) curve: the bits of x and y interleaved
+        std::uint64_t mortonIndex(std::uint32_t x, std::uint32_t y) {
+            auto spread = [](std::uint64_t v) {
+                v = (v | (v << 16)) & 0x0000ffff0000ffffULL;
+                v = (v | (v << 8)) & 0x00ff00ff00ff00ffULL;
+                v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+                v = (v | (v << 2)) & 0x3333333333333333ULL;
+                v = (v | (v << 1)) & 0x5555555555555555ULL;
+                return v;
+            };
+            return spread(x) | (spread(y) << 1);
+        }
+    }
+
+    /**
+     * @brief Order bounding boxes along a space-filling curve through their centers, which are snapped to a
+     * 2^32 x 2^32 grid over the extent of all boxes; boxes with the same curve position keep their relative order
+     * @param boxes Bounding boxes
+     * @param curve Hilbert (better locality) or Morton (cheaper) curve; None keeps the order
+     * @param threads # of threads computing the curve positions; 0 uses all hardware threads
+     * @return The indices of the boxes in curve order
+     */
+    std::vector<std::size_t> curveOrder(const std::vector<CGAL::Bbox_2>& boxes, SpatialOrder curve, unsigned threads) {
+        std::vector<std::size_t> order(boxes.size());
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+        if (curve == SpatialOrder::None || boxes.size() < 2) return order;
+
+        CGAL::Bbox_2 extent = boxes[0];
+        for (const CGAL::Bbox_2& box : boxes) extent = extent + box;
+        const double scale = (double)std::numeric_limits<std::uint32_t>::max();
+        const double width = extent.xmax() > extent.xmin() ? extent.xmax() - extent.xmin() : 1;
+        const double height = extent.ymax() > extent.ymin() ? extent.ymax() - extent.ymin() : 1;
+
+        std::vector<std::uint64_t> keys(boxes.size());
+        parallelFor(threadCount(threads, boxes.size()), boxes.size(), [&](unsigned, std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                const double cx = (boxes[i].xmin() + boxes[i].xmax()) / 2;
+                const double cy = (boxes[i].ymin() + boxes[i].ymax()) / 2;
+                const std::uint32_t x = (std::uint32_t)std::min(scale, std::max(0.0, (cx - extent.xmin()) / width * scale));
+                const std::uint32_t y = (std::uint32_t)std::min(scale, std::max(0.0, (cy - extent.ymin()) / height * scale));
+                keys[i] = curve == SpatialOrder::Hilbert ? hilbertIndex(x, y) : mortonIndex(x, y);
+            }
+        });
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+        return order;
+    }
+
+    /**
+     * @brief Open the export file
+     * @param filename Export target file
+     * @param options Export stages to apply
+     */
+    ExportWriter::ExportWriter(const std::string& filename, const ExportOptions& options)
+        : out(filename, std::ios::binary), options(options), layers(1) {
+        out << std::fixed << std::setprecision(10);
+        if (options.deduplicate) {
+            dedup.reset(new Deduplicator());
+        }
+        if (options.mergeSegments) {
+            chainer.reset(new SegmentChainer());
+        }
+    }
+
+    ExportWriter::~ExportWriter() {
+        close();
+    }
+
+    /**
+     * @brief Export one 2D geometry object, or drop it if it is a duplicate of a recently exported one
+     * @param geo2_Object String representation of a 2D geometry object
+     */
+    void ExportWriter::write(const std::string& geo2_Object) {
+        const std::uint64_t position = objects++;
+        if (chainer && chainer->add(geo2_Object, position, 0)) return;
+        order(geo2_Object, position, 0);
+    }
+
+    /**
+     * @brief Export one 2D geometry object into a layer. The export stages work within each layer: objects
+     * are only merged or deduplicated with objects of the same layer, and reordered within their layer.
+     * @param geo2_Object String representation of a 2D geometry object
+     * @param layer Layer name; runs of whitespace are written as one space, "" is the unnamed layer
+     */
+    void ExportWriter::write(const std::string& geo2_Object, const std::string& layer) {
+        const std::size_t layer_index = layerIndex(layer);
+        const std::uint64_t position = objects++;
+        if (chainer && chainer->add(geo2_Object, position, layer_index)) return;
+        order(geo2_Object, position, layer_index);
+    }
+
+    /**
+     * @brief Index of a layer in layers, adding it on first use
+     * @param layer Layer name, normalized the way readers split the LAYER line into tokens
+     */
+    std::size_t ExportWriter::layerIndex(const std::string& layer) {
+        std::string name;
+        for (char c : layer) {
+            const bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+            if (space && (name.empty() || name.back() == ' ')) continue;
+            name += space ? ' ' : c;
+        }
+        if (!name.empty() && name.back() == ' ') name.pop_back();
+
+        const auto found = std::find(layers.begin(), layers.end(), name);
+        if (found != layers.end()) return (std::size_t)(found - layers.begin());
+        layers.push_back(name);
+        return layers.size() - 1;
+    }
+
+    /**
+     * @brief Hold an object back for the spatial ordering, or pass it on to the deduplication stage
+     * @param geo2_Object String representation of a 2D geometry object
+     * @param id Original position of the object (NoRecordId for none)
+     * @param layer Index of the layer of the object
+     */
+    void ExportWriter::order(const std::string& geo2_Object, std::uint64_t id, std::size_t layer) {
+        if (options.spatialOrder != SpatialOrder::None) {
+            held.push_back({ geo2_Object, options.writeIds ? id : NoRecordId, layer });
+            return;
+        }
+        stage(geo2_Object, NoRecordId, layer);
+    }
+
+    /**
+     * @brief Run one object through the deduplication stage
+     * @param geo2_Object String representation of a 2D geometry object
+     * @param id Original position of the object, written as an "ID n" line (NoRecordId for none)
+     * @param layer Index of the layer of the object
+     */
+    void ExportWriter::stage(const std::string& geo2_Object, std::uint64_t id, std::size_t layer) {
+        if (!dedup) {
+            output(geo2_Object, 1, id, layer);
+            return;
+        }
+
+        // The key covers all records of the string; malformed objects are written as they are
+        MemoryBuffer buffer(geo2_Object.data(), geo2_Object.data() + geo2_Object.size());
+        std::istream in(&buffer);
+        ParseOptions parse_options;
+        parse_options.errorBudget = 0;
+        ParseReport report;
+        RecordReader reader(in, parse_options, report);
+        Record rec;
+        std::uint64_t key = layer;
+        std::string canonical(reinterpret_cast<const char*>(&key), sizeof(key));
+        while (reader.next(rec)) {
+            key = mix(key ^ hashSnapped(rec, options.dedupTolerance, &canonical));
+        }
+        if (!report.diagnostics.empty() || report.records == 0) {
+            output(geo2_Object, 1, id, layer);
+            return;
+        }
+
+        // A 64-bit key may collide; distinct objects with the same key are kept apart by their canonical values
+        const auto candidates = dedup->index.equal_range(key);
+        for (auto found = candidates.first; found != candidates.second; ++found) {
+            if (found->second->canonical != canonical) continue;
+            ++duplicates;
+            ++found->second->count;
+            dedup->recent.splice(dedup->recent.begin(), dedup->recent, found->second);
+            return;
+        }
+
+        dedup->recent.push_front({ key, std::move(canonical), 1, options.countDuplicates ? geo2_Object : std::string(), id, layer });
+        dedup->index.emplace(key, dedup->recent.begin());
+        if (!options.countDuplicates) {
+            output(geo2_Object, 1, id, layer);
+        }
+
+        if (dedup->recent.size() > options.dedupCapacity) {
+            const Deduplicator::Entry& oldest = dedup->recent.back();
+            if (options.countDuplicates) {
+                output(oldest.text, oldest.count, oldest.id, oldest.layer);
+            }
+            const auto candidates = dedup->index.equal_range(oldest.key);
+            for (auto found = candidates.first; found != candidates.second; ++found) {
+                if (&*found->second == &oldest) {
+                    dedup->index.erase(found);
+                    break;
+                }
+            }
+            dedup->recent.pop_back();
+        }
+    }
+
+    /**
+     * @brief Write the objects still held by the export stages and close the file
+     */
+    void ExportWriter::close() {
+        if (!out.is_open()) return;
+        if (chainer) {
+            // A merged polyline replaces several objects; it takes the original position of its first segment
+            for (const auto& group : chainer->groups) {
+                const std::size_t layer = std::get<0>(group.first);
+                const Color color = { std::get<1>(group.first), std::get<2>(group.first), std::get<3>(group.first), std::get<4>(group.first) };
+                const BoundaryType btype = static_cast<BoundaryType>(std::get<5>(group.first));
+                std::vector<std::size_t> first_segments;
+                const std::vector<Polyline_2> polylines = toPolylines(group.second.segments, first_segments);
+                for (std::size_t i = 0; i < polylines.size(); ++i) {
+                    const Polyline_2& polyline = polylines[i];
+                    const std::uint64_t id = group.second.ids[first_segments[i]];
+                    if (polyline.vertices.size() == 2) {
+                        order(toString(Segment_2(polyline.vertices[0], polyline.vertices[1]), color, btype), id, layer);
+                        continue;
+                    }
+                    merged += polyline.vertices.size() - 1;
+                    order(toString(polyline, color, btype), id, layer);
+                }
+            }
+            chainer.reset();
+        }
+        if (!held.empty()) {
+            std::vector<CGAL::Bbox_2> boxes(held.size());
+            std::vector<bool> bounded(held.size());
+            parallelFor(threadCount(options.threads, held.size()), held.size(), [&](unsigned, std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) bounded[i] = objectBounds(held[i].text, boxes[i]);
+            });
+
+            // Layer by layer; unbounded (LINE) or malformed objects go last, in their original order
+            std::vector<std::vector<std::size_t>> by_layer(layers.size());
+            for (std::size_t i = 0; i < held.size(); ++i) by_layer[held[i].layer].push_back(i);
+            for (const std::vector<std::size_t>& members : by_layer) {
+                std::vector<std::size_t> located;
+                std::vector<CGAL::Bbox_2> located_boxes;
+                for (std::size_t i : members) {
+                    if (!bounded[i]) continue;
+                    located.push_back(i);
+                    located_boxes.push_back(boxes[i]);
+                }
+                for (std::size_t i : curveOrder(located_boxes, options.spatialOrder, options.threads)) {
+                    const HeldObject& obj = held[located[i]];
+                    stage(obj.text, obj.id, obj.layer);
+                }
+                for (std::size_t i : members) {
+                    if (!bounded[i]) stage(held[i].text, held[i].id, held[i].layer);
+                }
+            }
+            held.clear();
+        }
+        if (dedup && options.countDuplicates) {
+            for (auto it = dedup->recent.rbegin(); it != dedup->recent.rend(); ++it) {
+                output(it->text, it->count, it->id, it->layer);
+            }
+        }
+        dedup.reset();
+        endBlock();
+        out.close();
+    }
+
+    /**
+     * @brief Write one object to the file, starting a new layer block if its layer differs from the previous object's
+     * @param geo2_Object String representation of a 2D geometry object
+     * @param repeat # of occurrences of the object, written as a "REPEAT n" line when greater than 1
+     * @param id Original position of the object, written as an "ID n" line unless it is NoRecordId
+     * @param layer Index of the layer of the object
+     */
+    void ExportWriter::output(const std::string& geo2_Object, std::size_t repeat, std::uint64_t id, std::size_t layer) {
+        if (layer != blockLayer) {
+            // The length of the LAYER line is left blank and filled in once the block is complete
+            endBlock();
+            out << "LAYER" << (layers[layer].empty() ? "" : " ") << layers[layer] << ' ';
+            blockLength = (std::streamoff)out.tellp();
+            out << '@' << std::string(LayerLengthWidth, ' ') << '\n';
+            blockStart = (std::streamoff)out.tellp();
+            blockLines = 0;
+            blockLayer = layer;
+            blockOpen = true;
+        }
+
+        if (repeat > 1) {
+            out << "REPEAT " << repeat << '\n';
+            ++blockLines;
+        }
+        if (id != NoRecordId) {
+            out << "ID " << id << '\n';
+            ++blockLines;
+        }
+        if (options.lengthPrefixed) {
+            const std::string text = withLengths(geo2_Object);
+            out << text;
+            blockLines += (std::size_t)std::count(text.begin(), text.end(), '\n');
+        }
+        else {
+            out << geo2_Object << '\n';
+            blockLines += (std::size_t)std::count(geo2_Object.begin(), geo2_Object.end(), '\n') + 1;
+        }
+    }
+
+    /**
+     * @brief Fill in the length ("@bytes/lines") of the open layer block
+     */
+    void ExportWriter::endBlock() {
+        if (!blockOpen) return;
+        const std::streamoff end = (std::streamoff)out.tellp();
+        out.seekp(blockLength);
+        out << '@' << (end - blockStart) << '/' << blockLines;
+        out.seekp(end);
+        blockOpen = false;
+    }
+
+    /**
+     * @brief Export a collect of 2D geometry objects to a file, through the export stages selected by options
+     * @param filename Export target file
+     * @param geo2_Objects String representations of a collection of 2D geometry objects
+     * @param options Export stages to apply
+     */
+    void printToFile(const std::string& filename, const std::vector<std::string>& geo2_Objects, const ExportOptions& options) {
+        ExportWriter writer(filename, options);
+        for (const std::string& obj : geo2_Objects) {
+            writer.write(obj);
+        }
+        writer.close();
+    }
+
+    /**
+     * @brief Export a collection of 2D geometry objects to a file, as a single layer block
+     * @param filename Export target file
+     * @param geo2_Objects String representations of a collection of 2D geometry objects
+     * @param options Export stages to apply
+     * @param layer Layer name
+     */
+    void printToFile(const std::string& filename, const std::vector<std::string>& geo2_Objects, const ExportOptions& options, const std::string& layer) {
+        ExportWriter writer(filename, options);
+        for (const std::string& obj : geo2_Objects) {
+            writer.write(obj, layer);
+        }
+        writer.close();
+    }
+}
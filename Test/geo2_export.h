@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    // Space-filling curve of a spatially ordered export
+    enum class SpatialOrder : short {
+        None = 0,
+        Hilbert,
+        Morton
+    };
+
+    struct ExportOptions {
+        // Write each distinct object (same type, style and coordinates) only once
+        bool deduplicate = false;
+        // Coordinates are snapped to a grid of this size before they are compared; 0 compares them exactly
+        double dedupTolerance = 0.0;
+        // Precede objects that occurred n > 1 times with a "REPEAT n" line; objects are then written when they
+        // leave the dedup window (or on close), i.e. no longer in the original order
+        bool countDuplicates = false;
+        // Max. # of distinct objects remembered; the least recently seen one is forgotten first
+        std::size_t dedupCapacity = 1 << 20;
+        // Append "@bytes/lines" (size of the detail lines) to every header, so that readers can skip records with one seek
+        bool lengthPrefixed = false;
+        // Write the objects along a space-filling curve through their bounding box centers, each preceded by an
+        // "ID n" line with its original position; objects are then held back until close()
+        SpatialOrder spatialOrder = SpatialOrder::None;
+        // Write the "ID n" lines of a spatially ordered export; without them the original order is lost
+        bool writeIds = true;
+        // # of threads computing the curve keys; 0 uses all hardware threads
+        unsigned threads = 0;
+        // Chain LINE_SEGMENT objects of the same style that share endpoints into POLYLINE objects;
+        // the segments are held back until close()
+        bool mergeSegments = false;
+    };
+
+    // Dedup window and segment merging stage of an ExportWriter; defined in geo2_export.cpp
+    struct Deduplicator;
+    struct SegmentChainer;
+
+    /**
+     * Streaming export of 2D geometry objects to a file, with optional export stages.
+     * Objects are written as they come, so exports of any size run in bounded memory.
+     */
+    class ExportWriter {
+    public:
+        explicit ExportWriter(const std::string& filename, const ExportOptions& options = ExportOptions());
+        ~ExportWriter();
+
+        ExportWriter(const ExportWriter&) = delete;
+        ExportWriter& operator=(const ExportWriter&) = delete;
+
+        // Export the string representation of one object (see toString)
+        void write(const std::string& geo2_Object);
+        // Export one object into a named layer; consecutive objects of a layer form one "LAYER" block
+        void write(const std::string& geo2_Object, const std::string& layer);
+        // Flush the pending objects and close the file
+        void close();
+
+        // # of objects passed to write() / # of those that were dropped as duplicates
+        std::size_t objectCount() const { return objects; }
+        std::size_t duplicateCount() const { return duplicates; }
+        // # of segments that were merged into polylines
+        std::size_t mergedCount() const { return merged; }
+
+    private:
+        // Object waiting for the spatial ordering, with its position and layer (index into layers)
+        struct HeldObject {
+            std::string text;
+            std::uint64_t id;
+            std::size_t layer;
+        };
+
+        std::size_t layerIndex(const std::string& layer);
+        void order(const std::string& geo2_Object, std::uint64_t id, std::size_t layer);
+        void stage(const std::string& geo2_Object, std::uint64_t id, std::size_t layer);
+        void output(const std::string& geo2_Object, std::size_t repeat, std::uint64_t id, std::size_t layer);
+        void endBlock();
+
+        std::ofstream out;
+        ExportOptions options;
+        std::unique_ptr<Deduplicator> dedup;
+        std::unique_ptr<SegmentChainer> chainer;
+        std::vector<HeldObject> held;
+        std::vector<std::string> layers;            // layer names in the order of first use; layers[0] is the unnamed layer ""
+        std::size_t blockLayer = 0;                 // layer of the objects being written
+        bool blockOpen = false;                     // a LAYER line has been written whose length is still blank
+        std::streamoff blockLength = 0;             // position of the blank length token of that LAYER line
+        std::streamoff blockStart = 0;
+        std::size_t blockLines = 0;
+        std::size_t objects = 0;
+        std::size_t duplicates = 0;
+        std::size_t merged = 0;
+    };
+
+    // Export a collection of 2D geometry objects through an ExportWriter
+    void printToFile(const std::string& filename, const std::vector<std::string>& geo2_Objects, const ExportOptions& options);
+    // Export a collection of 2D geometry objects into one layer of a new file
+    void printToFile(const std::string& filename, const std::vector<std::string>& geo2_Objects, const ExportOptions& options, const std::string& layer);
+
+    // Order of bounding boxes along a space-filling curve through their centers (computed in parallel)
+    std::vector<std::size_t> curveOrder(const std::vector<CGAL::Bbox_2>& boxes, SpatialOrder curve, unsigned threads = 0);
+
+    inline CGAL::Bbox_2 boundsOf(const Polygon_with_holes_2& poly_w_h) { return poly_w_h.outer_boundary().bbox(); }
+    template <class Object>
+    CGAL::Bbox_2 boundsOf(const Object& obj) { return obj.bbox(); }
+
+    // Sort CGAL objects (e.g. a set of polygons) along a space-filling curve; returns the original position of each object
+    template <class Object>
+    std::vector<std::size_t> spatialSort(std::vector<Object>& objs, SpatialOrder curve = SpatialOrder::Hilbert) {
+        std::vector<CGAL::Bbox_2> boxes;
+        boxes.reserve(objs.size());
+        for (const Object& obj : objs) boxes.push_back(boundsOf(obj));
+        const std::vector<std::size_t> order = curveOrder(boxes, curve);
+
+        std::vector<Object> sorted;
+        sorted.reserve(objs.size());
+        for (std::size_t i : order) sorted.push_back(objs[i]);
+        objs.swap(sorted);
+        return order;
+    }
+
+    // Add the "@bytes/lines" length token to the headers (incl. nested ones) of an object
+    std::string withLengths(const std::string& geo2_Object);
+
+    // Tolerance-aware hash of the geometry and style of a record; records that are equal after snapping hash equal
+    std::uint64_t hashRecord(const Record& rec, double tolerance);
+}
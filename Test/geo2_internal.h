@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Helpers shared by the geo2 modules; included by their .cpp files only
+namespace Geo2Util {
+    namespace internal {
+        // Byte order tag of the binary side files (snapshots, record indices); they are only read on machines of the same byte order
+        const std::uint32_t ByteOrderMark = 0x01020304;
+
+        // splitmix64 finalizer
+        inline std::uint64_t mix(std::uint64_t h) {
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9ULL;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111ebULL;
+            h ^= h >> 31;
+            return h;
+        }
+
+        // # of threads for size items: threads (0: all hardware threads), but at least minPerThread items per thread
+        inline unsigned threadCount(unsigned threads, std::size_t size, std::size_t minPerThread) {
+            const unsigned wanted = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+            return (unsigned)std::max<std::size_t>(1, std::min<std::size_t>(wanted, size / minPerThread));
+        }
+
+        // Run task(thread, first, last) on numThreads threads, each with an equal share of [0, size);
+        // thread 0 is the calling thread
+        template <class Task>
+        void parallelFor(unsigned numThreads, std::size_t size, Task task) {
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < numThreads; ++t) {
+                threads.emplace_back(task, t, size * t / numThreads, size * (t + 1) / numThreads);
+            }
+            task(0u, (std::size_t)0, size / numThreads);
+            for (std::thread& thread : threads) thread.join();
+        }
+    }
+}
@@ -0,0 +1,499 @@
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "geo2_intersect.h"
+#include "geo2_internal.h"
+
+namespace Geo2Util {
+    namespace {
+        // Min. # of segments per search thread
+        const std::size_t MinSegmentsPerThread = 1 << 12;
+        // # of objects a thread collects before it passes them to the export
+        const std::size_t FlushObjects = 4096;
+        const std::uint32_t NoSegment = 0xFFFFFFFFu;
+
+        unsigned threadCount(unsigned threads, std::size_t numSegments) {
+            return internal::threadCount(threads, numSegments, MinSegmentsPerThread);
+        }
+
+        bool lexLess(const Point_2& a, const Point_2& b) {
+            return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+        }
+
+        // Endpoints of a segment in sweep order (by x, then by y)
+        Point_2 leftEnd(const Segment_2& seg) {
+            return lexLess(seg.target(), seg.source()) ? seg.target() : seg.source();
+        }
+        Point_2 rightEnd(const Segment_2& seg) {
+            return lexLess(seg.target(), seg.source()) ? seg.source() : seg.target();
+        }
+
+        /**
+         * @brief Test two segments for an intersection (with exact predicates)
+         * @param p Intersection point (within the bounding boxes of both segments); the midpoint of the overlap
+         * of collinear segments
+         * @return false if the segments are disjoint (or only share an endpoint, if ignoreSharedEndpoints)
+         */
+        bool intersect(const Segment_2& a, const Segment_2& b, bool ignoreSharedEndpoints, Point_2& p) {
+            const Point_2& p1 = a.source();
+            const Point_2& q1 = a.target();
+            const Point_2& p2 = b.source();
+            const Point_2& q2 = b.target();
+            const CGAL::Orientation o1 = CGAL::orientation(p1, q1, p2);
+            const CGAL::Orientation o2 = CGAL::orientation(p1, q1, q2);
+            if (o1 == o2 && o1 != CGAL::COLLINEAR) return false;
+            const CGAL::Orientation o3 = CGAL::orientation(p2, q2, p1);
+            const CGAL::Orientation o4 = CGAL::orientation(p2, q2, q1);
+            if (o3 == o4 && o3 != CGAL::COLLINEAR) return false;
+
+            if (o1 == CGAL::COLLINEAR && o2 == CGAL::COLLINEAR && o3 == CGAL::COLLINEAR && o4 == CGAL::COLLINEAR) {
+                const Point_2 lo = std::max(std::min(p1, q1, lexLess), std::min(p2, q2, lexLess), lexLess);
+                const Point_2 hi = std::min(std::max(p1, q1, lexLess), std::max(p2, q2, lexLess), lexLess);
+                if (lexLess(hi, lo)) return false;
+                if (!(lo == hi)) {
+                    p = Point_2((lo.x() + hi.x()) / 2, (lo.y() + hi.y()) / 2);
+                    return true;
+                }
+                p = lo;
+            }
+            else if (o1 == CGAL::COLLINEAR) p = p2;
+            else if (o2 == CGAL::COLLINEAR) p = q2;
+            else if (o3 == CGAL::COLLINEAR) p = p1;
+            else if (o4 == CGAL::COLLINEAR) p = q1;
+            else {
+                const double dx1 = q1.x() - p1.x(), dy1 = q1.y() - p1.y();
+                const double dx2 = q2.x() - p2.x(), dy2 = q2.y() - p2.y();
+                const double t = ((p2.x() - p1.x()) * dy2 - (p2.y() - p1.y()) * dx2) / (dx1 * dy2 - dy1 * dx2);
+                const double u = std::min(1.0, std::max(0.0, t));
+                // Keep the rounded point within both segments, so that both are searched where it is reported
+                const CGAL::Bbox_2 ba = a.bbox(), bb = b.bbox();
+                const double x = std::min(std::min(ba.xmax(), bb.xmax()), std::max(std::max(ba.xmin(), bb.xmin()), p1.x() + u * dx1));
+                const double y = std::min(std::min(ba.ymax(), bb.ymax()), std::max(std::max(ba.ymin(), bb.ymin()), p1.y() + u * dy1));
+                p = Point_2(x, y);
+            }
+            return !(ignoreSharedEndpoints && (p == p1 || p == q1) && (p == p2 || p == q2));
+        }
+
+        // True if p lies on the segment
+        bool contains(const Segment_2& seg, const Point_2& p) {
+            const Point_2 l = leftEnd(seg), r = rightEnd(seg);
+            return !lexLess(p, l) && !lexLess(r, p) && CGAL::orientation(l, r, p) == CGAL::COLLINEAR;
+        }
+
+        bool collinear(const Segment_2& a, const Segment_2& b) {
+            return CGAL::orientation(a.source(), a.target(), b.source()) == CGAL::COLLINEAR
+                && CGAL::orientation(a.source(), a.target(), b.target()) == CGAL::COLLINEAR;
+        }
+
+        /**
+         * @brief True if lo, directly below hi on the sweep line, ends above the line of hi or hi ends below
+         * the line of lo, i.e. the two (if they meet) change their order to the right
+         */
+        bool swapsAhead(const Segment_2& lo, const Segment_2& hi) {
+            return CGAL::orientation(leftEnd(lo), rightEnd(lo), rightEnd(hi)) == CGAL::RIGHT_TURN
+                || CGAL::orientation(leftEnd(hi), rightEnd(hi), rightEnd(lo)) == CGAL::LEFT_TURN;
+        }
+
+        /**
+         * @brief True if the first common point of two meeting segments lies left of the vertical line through
+         * bound (exact, also for crossings that can only be rounded)
+         */
+        bool meetsBefore(const Segment_2& a, const Segment_2& b, const Point_2& bound) {
+            const Point_2 la = leftEnd(a), ra = rightEnd(a), lb = leftEnd(b), rb = rightEnd(b);
+            if (collinear(a, b)) return std::max(la, lb, lexLess).x() < bound.x();
+            Point_2 p;
+            intersect(a, b, false, p);
+            if (p == la || p == ra || p == lb || p == rb) return p.x() < bound.x();
+            if (std::min(ra.x(), rb.x()) < bound.x()) return true;
+            if (std::max(la.x(), lb.x()) >= bound.x()) return false;
+            // Proper crossing of the line: left of it if the order there is the one right of the crossing
+            const CGAL::Comparison_result order = CGAL::compare_y_at_x(bound, a, b);
+            if (order == CGAL::EQUAL) return false;
+            return (order == CGAL::SMALLER) == (CGAL::orientation(la, ra, rb) == CGAL::LEFT_TURN);
+        }
+
+        typedef std::function<bool(std::size_t i, std::size_t j, const Point_2& p)> PairSink;
+
+        /**
+         * Bentley-Ottmann sweep over the segments of one vertical slab: the segments on the sweep line are kept
+         * in y order and only neighbours are tested, so n segments with k intersections cost O((n + k) log n).
+         * Segments entering the slab from the left are ordered by their height at its left boundary. Each pair is
+         * reported by the slab of its first common point, which is decided with exact predicates.
+         */
+        class SlabSweep {
+        public:
+            // bounds: points on the slab boundaries; slab s lies between bounds[s] and bounds[s + 1]
+            SlabSweep(const std::vector<Segment_2>& input, const std::vector<Point_2>& bounds, std::size_t slab,
+                bool ignoreSharedEndpoints, const PairSink& sink)
+                : input(input), bounds(bounds), slab(slab), ignoreSharedEndpoints(ignoreSharedEndpoints),
+                sink(sink), status(EntryLess{ this }) {
+            }
+
+            /**
+             * @brief Sweep the slab
+             * @param entering Segments starting left of the slab and reaching into it
+             * @param starting Segments starting in the slab, in sweep order of their left ends
+             */
+            void run(const std::vector<std::uint32_t>& entering, const std::uint32_t* starting, std::size_t numStarting) {
+                // Local copies (directed from the left to the right end): the entering segments, then the others
+                // in sweep order
+                segs.reserve(entering.size() + numStarting);
+                ids.reserve(entering.size() + numStarting);
+                for (std::uint32_t id : entering) add(id);
+                for (std::size_t k = 0; k < numStarting; ++k) add(starting[k]);
+                std::vector<std::uint32_t> ending;
+                for (std::uint32_t seg = 0; seg < segs.size(); ++seg) {
+                    if (segs[seg].target().x() < bounds[slab + 1].x()) ending.push_back(seg);
+                }
+                std::sort(ending.begin(), ending.end(), [&](std::uint32_t a, std::uint32_t b) {
+                    return lexLess(segs[a].target(), segs[b].target());
+                });
+                where.assign(segs.size(), status.end());
+
+                enter(entering.size());
+                std::size_t next_start = entering.size(), next_end = 0;
+                while (!stopped) {
+                    bool found = false;
+                    Point_2 p;
+                    auto earliest = [&](const Point_2& q) {
+                        if (!found || lexLess(q, p)) p = q;
+                        found = true;
+                    };
+                    if (next_start < segs.size()) earliest(segs[next_start].source());
+                    if (next_end < ending.size()) earliest(segs[ending[next_end]].target());
+                    if (!crossings.empty()) earliest(crossings.begin()->at);
+                    if (!found) break;
+
+                    at = p;
+                    if ((next_start < segs.size() && segs[next_start].source() == at)
+                        || (next_end < ending.size() && segs[ending[next_end]].target() == at)) {
+                        passPoint(next_start, ending, next_end);
+                    }
+                    else {
+                        cross();
+                    }
+                }
+            }
+
+        private:
+            // Crossing of two neighbours on the sweep line (lo below hi)
+            struct Crossing {
+                Point_2 at;
+                std::uint32_t lo, hi;
+            };
+            struct CrossingLess {
+                bool operator()(const Crossing& a, const Crossing& b) const {
+                    if (lexLess(a.at, b.at)) return true;
+                    if (lexLess(b.at, a.at)) return false;
+                    return a.lo < b.lo || (a.lo == b.lo && a.hi < b.hi);
+                }
+            };
+            typedef std::set<Crossing, CrossingLess> CrossingQueue;
+
+            // Segment on the sweep line; owns the crossing scheduled with its upper neighbour
+            struct Entry {
+                mutable std::uint32_t seg;
+                mutable std::size_t rank;           // position among the entering segments
+                mutable bool scheduled;
+                mutable CrossingQueue::iterator crossing;
+            };
+            struct EntryLess {
+                const SlabSweep* sweep;
+                bool operator()(const Entry& a, const Entry& b) const { return sweep->below(a, b); }
+            };
+            typedef std::multiset<Entry, EntryLess> Status;
+
+            const std::vector<Segment_2>& input;
+            const std::vector<Point_2>& bounds;
+            const std::size_t slab;
+            const bool ignoreSharedEndpoints;
+            const PairSink& sink;
+
+            std::vector<Segment_2> segs;            // local copies of the segments of the slab
+            std::vector<std::uint32_t> ids;         // their indices in the input
+            Point_2 at;                             // current event point
+            bool building = false;                  // status ordered by rank while the entering segments are added
+            bool stopped = false;
+            CrossingQueue crossings;
+            Status status;
+            std::vector<Status::iterator> where;    // position of a segment on the sweep line (or status.end())
+            std::vector<std::uint32_t> members, continuing;
+
+            /**
+             * @brief Order on the sweep line just right of the event point; one of the two entries is new (it
+             * passes through the event point) or the probe NoSegment, which stands for the event point itself
+             */
+            bool below(const Entry& a, const Entry& b) const {
+                if (building) return a.rank < b.rank;
+                const bool a_at = a.seg == NoSegment || contains(segs[a.seg], at);
+                const bool b_at = b.seg == NoSegment || contains(segs[b.seg], at);
+                if (a_at && b_at) {
+                    if (a.seg == NoSegment || b.seg == NoSegment || a.seg == b.seg) return false;
+                    const CGAL::Orientation o = CGAL::orientation(at, segs[a.seg].target(), segs[b.seg].target());
+                    return o == CGAL::COLLINEAR ? a.seg < b.seg : o == CGAL::LEFT_TURN;
+                }
+                if (a_at) return CGAL::orientation(segs[b.seg].source(), segs[b.seg].target(), at) == CGAL::RIGHT_TURN;
+                if (b_at) return CGAL::orientation(segs[a.seg].source(), segs[a.seg].target(), at) == CGAL::LEFT_TURN;
+                return CGAL::compare_y_at_x(at, segs[a.seg], segs[b.seg]) == CGAL::SMALLER;
+            }
+
+            bool isFirstSlab() const { return slab == 0; }
+            bool isLastSlab() const { return slab + 2 == bounds.size(); }
+
+            void add(std::uint32_t id) {
+                segs.push_back(Segment_2(leftEnd(input[id]), rightEnd(input[id])));
+                ids.push_back(id);
+            }
+
+            /**
+             * @brief Put the segments entering the slab on the sweep line, ordered by their height at the left
+             * boundary; segments meeting on the boundary are ordered as just left of it
+             */
+            void enter(std::size_t numEntering) {
+                const Point_2& bound = bounds[slab];
+                std::vector<std::uint32_t> sorted(numEntering);
+                for (std::size_t k = 0; k < numEntering; ++k) sorted[k] = (std::uint32_t)k;
+                std::sort(sorted.begin(), sorted.end(), [&](std::uint32_t a, std::uint32_t b) {
+                    const CGAL::Comparison_result order = CGAL::compare_y_at_x(bound, segs[a], segs[b]);
+                    if (order != CGAL::EQUAL) return order == CGAL::SMALLER;
+                    const CGAL::Orientation side = CGAL::orientation(segs[b].source(), segs[b].target(), segs[a].source());
+                    return side == CGAL::COLLINEAR ? a < b : side == CGAL::RIGHT_TURN;
+                });
+
+                building = true;
+                for (std::size_t k = 0; k < sorted.size(); ++k) {
+                    where[sorted[k]] = status.emplace_hint(status.end(), Entry{ sorted[k], k, false, CrossingQueue::iterator() });
+                }
+                building = false;
+                at = Point_2(bound.x(), -std::numeric_limits<double>::max());
+                for (Status::iterator it = status.begin(); it != status.end(); ++it) schedule(it, std::next(it));
+            }
+
+            /**
+             * @brief Event at an endpoint: report the pairs meeting there first, then replace the segments through
+             * the point by those continuing to the right (in their order right of the point)
+             */
+            void passPoint(std::size_t& nextStart, const std::vector<std::uint32_t>& ending, std::size_t& nextEnd) {
+                members.clear();
+                const Status::iterator first = status.lower_bound(Entry{ NoSegment, 0, false, CrossingQueue::iterator() });
+                Status::iterator last = first;
+                for (; last != status.end() && contains(segs[last->seg], at); ++last) members.push_back(last->seg);
+                const std::size_t passing = members.size();
+                while (nextStart < segs.size() && segs[nextStart].source() == at) members.push_back((std::uint32_t)nextStart++);
+                const std::size_t first_end = nextEnd;
+                while (nextEnd < ending.size() && segs[ending[nextEnd]].target() == at) ++nextEnd;
+
+                for (std::size_t a = 0; a < members.size(); ++a) {
+                    for (std::size_t b = a + 1; b < members.size(); ++b) {
+                        const Segment_2& lo = segs[members[a]];
+                        const Segment_2& hi = segs[members[b]];
+                        if (b < passing) {
+                            // Both were on the sweep line: skip overlaps (reported where they began) and pairs
+                            // already swapped at a rounded crossing point
+                            if (collinear(lo, hi)) continue;
+                            if (!(lo.target() == at && hi.target() == at) && !swapsAhead(lo, hi)) continue;
+                        }
+                        if (!report(members[a], members[b])) return;
+                    }
+                }
+
+                const Status::iterator before = first == status.begin() ? status.end() : std::prev(first);
+                unschedule(before);
+                for (Status::iterator it = first; it != last; ++it) {
+                    unschedule(it);
+                    where[it->seg] = status.end();
+                }
+                status.erase(first, last);
+
+                continuing.clear();
+                for (std::uint32_t seg : members) {
+                    if (!(segs[seg].target() == at)) continuing.push_back(seg);
+                }
+                std::sort(continuing.begin(), continuing.end(), [&](std::uint32_t a, std::uint32_t b) {
+                    const CGAL::Orientation o = CGAL::orientation(at, segs[a].target(), segs[b].target());
+                    return o == CGAL::COLLINEAR ? a < b : o == CGAL::LEFT_TURN;
+                });
+                Status::iterator lowest = last, highest = last;
+                for (std::size_t k = 0; k < continuing.size(); ++k) {
+                    highest = status.emplace_hint(last, Entry{ continuing[k], 0, false, CrossingQueue::iterator() });
+                    where[continuing[k]] = highest;
+                    if (k == 0) lowest = highest;
+                }
+                if (continuing.empty()) {
+                    schedule(before, last);
+                }
+                else {
+                    schedule(before, lowest);
+                    schedule(highest, last);
+                }
+
+                // Segments ending here that were not found through the point (rounding) leave the sweep line anyway
+                for (std::size_t k = first_end; k < nextEnd; ++k) {
+                    if (where[ending[k]] != status.end()) remove(where[ending[k]]);
+                }
+            }
+
+            // Event at the crossing of two neighbours: report them and swap them
+            void cross() {
+                const Crossing crossing = *crossings.begin();
+                crossings.erase(crossings.begin());
+                const Status::iterator lo = where[crossing.lo];
+                const Status::iterator hi = std::next(lo);
+                lo->scheduled = false;
+                if (!report(crossing.lo, crossing.hi)) return;
+
+                const Status::iterator before = lo == status.begin() ? status.end() : std::prev(lo);
+                unschedule(before);
+                unschedule(hi);
+                std::swap(lo->seg, hi->seg);
+                where[lo->seg] = lo;
+                where[hi->seg] = hi;
+                schedule(before, lo);
+                schedule(hi, std::next(hi));
+            }
+
+            void remove(Status::iterator it) {
+                const Status::iterator before = it == status.begin() ? status.end() : std::prev(it);
+                const Status::iterator after = std::next(it);
+                unschedule(before);
+                unschedule(it);
+                where[it->seg] = status.end();
+                status.erase(it);
+                schedule(before, after);
+            }
+
+            // Schedule the crossing of two neighbours if they meet right of the sweep line
+            void schedule(Status::iterator lo, Status::iterator hi) {
+                if (lo == status.end() || hi == status.end()) return;
+                const Segment_2& a = segs[lo->seg];
+                const Segment_2& b = segs[hi->seg];
+                if (collinear(a, b) || !swapsAhead(a, b)) return;
+                Point_2 p;
+                if (!intersect(segs[std::min(lo->seg, hi->seg)], segs[std::max(lo->seg, hi->seg)], false, p)) return;
+                if (!isLastSlab() && !meetsBefore(a, b, bounds[slab + 1])) return;
+                if (lexLess(p, at)) p = at;
+                lo->crossing = crossings.insert(Crossing{ p, lo->seg, hi->seg }).first;
+                lo->scheduled = true;
+            }
+
+            void unschedule(Status::iterator it) {
+                if (it == status.end() || !it->scheduled) return;
+                crossings.erase(it->crossing);
+                it->scheduled = false;
+            }
+
+            /**
+             * @brief Pass a meeting pair to the sink if this slab holds its first common point
+             * @return false once the sink stops the search
+             */
+            bool report(std::uint32_t a, std::uint32_t b) {
+                const std::uint32_t i = std::min(ids[a], ids[b]), j = std::max(ids[a], ids[b]);
+                Point_2 p;
+                if (!intersect(input[i], input[j], ignoreSharedEndpoints, p)) return true;
+                if (!isFirstSlab() && meetsBefore(input[i], input[j], bounds[slab])) return true;
+                if (!isLastSlab() && !meetsBefore(input[i], input[j], bounds[slab + 1])) return true;
+                if (!sink(i, j, p)) stopped = true;
+                return !stopped;
+            }
+        };
+    }
+
+    /**
+     * @brief Find all pairs of intersecting segments (plane sweep, vertical slabs in parallel)
+     * @param segs Segment_2 objects (at most 2^32 - 1)
+     * @param options # of threads, max. # of intersections
+     * @param visit Called for every intersecting pair, concurrently from the search threads
+     * @return # of intersections visited
+     */
+    std::size_t forEachIntersection(const std::vector<Segment_2>& segs, const IntersectionOptions& options, const IntersectionVisitor& visit) {
+        if (segs.size() > 0xFFFFFFFFu) throw std::length_error("forEachIntersection: too many segments");
+        if (segs.empty()) return 0;
+
+        // Segments in sweep order of their left ends; the slabs hold about the same # of left ends
+        std::vector<std::uint32_t> order(segs.size());
+        for (std::size_t i = 0; i < segs.size(); ++i) order[i] = (std::uint32_t)i;
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return lexLess(leftEnd(segs[a]), leftEnd(segs[b]));
+        });
+        const unsigned num_slabs = threadCount(options.threads, segs.size());
+        std::vector<Point_2> bounds(num_slabs + 1);
+        bounds[0] = Point_2(-std::numeric_limits<double>::infinity(), 0);
+        bounds[num_slabs] = Point_2(std::numeric_limits<double>::infinity(), 0);
+        for (unsigned slab = 1; slab < num_slabs; ++slab) bounds[slab] = leftEnd(segs[order[slab * segs.size() / num_slabs]]);
+        std::vector<std::size_t> starts(num_slabs + 1, segs.size());
+        for (unsigned slab = 0; slab < num_slabs; ++slab) {
+            starts[slab] = std::partition_point(order.begin(), order.end(), [&](std::uint32_t seg) {
+                return leftEnd(segs[seg]).x() < bounds[slab].x();
+            }) - order.begin();
+        }
+
+        std::atomic<std::size_t> found(0);
+        std::atomic<bool> stop(false);
+        auto search = [&](unsigned slab) {
+            const PairSink sink = [&](std::size_t i, std::size_t j, const Point_2& p) {
+                if (stop) return false;
+                if (found.fetch_add(1) >= options.maxIntersections) {
+                    stop = true;
+                    return false;
+                }
+                visit(slab, i, j, p);
+                return true;
+            };
+            // A segment is searched in every slab it reaches into
+            std::vector<std::uint32_t> entering;
+            for (std::size_t k = 0; k < starts[slab]; ++k) {
+                if (rightEnd(segs[order[k]]).x() >= bounds[slab].x()) entering.push_back(order[k]);
+            }
+            SlabSweep sweep(segs, bounds, slab, options.ignoreSharedEndpoints, sink);
+            sweep.run(entering, order.data() + starts[slab], starts[slab + 1] - starts[slab]);
+        };
+        internal::parallelFor(num_slabs, num_slabs, [&](unsigned slab, std::size_t, std::size_t) { search(slab); });
+        return std::min<std::size_t>(found, options.maxIntersections);
+    }
+
+    /**
+     * @brief Export the intersection points of a set of segments, and each segment involved in an
+     * intersection, in highlight styles. Objects are passed to the writer in batches while the search runs.
+     * @param segs Segment_2 objects
+     * @param writer Export the objects are written to
+     * @param options Search options (see forEachIntersection)
+     * @param style Highlight styles
+     * @return # of intersections and of offending segments
+     */
+    IntersectionReport exportIntersections(const std::vector<Segment_2>& segs, ExportWriter& writer,
+        const IntersectionOptions& options, const IntersectionStyle& style) {
+        std::vector<std::atomic<bool>> flagged(segs.size());
+        std::vector<std::vector<std::string>> pending(threadCount(options.threads, segs.size()));
+        std::mutex writer_mutex;
+        auto flush = [&](std::vector<std::string>& objs) {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            for (const std::string& obj : objs) writer.write(obj);
+            objs.clear();
+        };
+
+        IntersectionReport report;
+        report.intersections = forEachIntersection(segs, options, [&](unsigned thread, std::size_t i, std::size_t j, const Point_2& p) {
+            std::vector<std::string>& objs = pending[thread];
+            objs.push_back(toString(p, style.pointColor, DefaultBoundaryType, style.pointColor));
+            for (std::size_t k : { i, j }) {
+                if (!flagged[k].exchange(true) && style.writeSegments) {
+                    objs.push_back(toString(segs[k], style.segmentColor, style.segmentType));
+                }
+            }
+            if (objs.size() >= FlushObjects) flush(objs);
+        });
+        for (std::vector<std::string>& objs : pending) flush(objs);
+        for (const std::atomic<bool>& flag : flagged) {
+            if (flag) ++report.segments;
+        }
+        return report;
+    }
+}
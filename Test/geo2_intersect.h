@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "geo2_export.h"
+
+namespace Geo2Util {
+    struct IntersectionOptions {
+        // Segments that only touch at a common endpoint (consecutive segments of a network) do not intersect
+        bool ignoreSharedEndpoints = true;
+        // Stop after this many intersections
+        std::size_t maxIntersections = std::numeric_limits<std::size_t>::max();
+        // # of threads, each sweeping one vertical slab (a segment is searched in every slab it reaches into);
+        // 0 uses all hardware threads
+        unsigned threads = 0;
+    };
+
+    // Highlight style of an exported intersection report
+    struct IntersectionStyle {
+        Color pointColor = { 255, 0, 0, 255 };          // intersection points
+        Color segmentColor = { 255, 140, 0, 255 };      // segments with at least one intersection
+        BoundaryType segmentType = BoundaryType::Dashed;
+        bool writeSegments = true;                      // also export the offending segments (each once)
+    };
+
+    // # of intersections found / # of distinct segments involved in them
+    struct IntersectionReport {
+        std::size_t intersections = 0;
+        std::size_t segments = 0;
+    };
+
+    // Called with the thread index, the indices (i < j) of two intersecting segments and their intersection point
+    typedef std::function<void(unsigned thread, std::size_t i, std::size_t j, const Point_2& p)> IntersectionVisitor;
+
+    /**
+     * Find all pairs of intersecting segments with a plane sweep (Bentley-Ottmann) in O((n + k) log n) for n
+     * segments and k intersections; vertical slabs with about the same # of segments are swept in parallel.
+     * Each pair is visited once, from the thread that sweeps the slab of its first common point; overlapping
+     * collinear segments are visited with the midpoint of their overlap. Returns the # of visited pairs.
+     */
+    std::size_t forEachIntersection(const std::vector<Segment_2>& segs, const IntersectionOptions& options, const IntersectionVisitor& visit);
+
+    // Stream the intersection points (and the offending segments) of a set of segments into an export
+    IntersectionReport exportIntersections(const std::vector<Segment_2>& segs, ExportWriter& writer,
+        const IntersectionOptions& options = IntersectionOptions(), const IntersectionStyle& style = IntersectionStyle());
+}
@@ -0,0 +1,1043 @@
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <set>
+#include <vector>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    namespace {
+        // Header keyword of a record type; string literals, so the view never dangles
+        std::string_view keywordOf(const RecordType type) {
+            switch (type) {
+                case RecordType::Point : return "POINT";
+                case RecordType::Segment : return "LINE_SEGMENT";
+                case RecordType::Circle : return "CIRCLE";
+                case RecordType::Triangle : return "TRIANGLE";
+                case RecordType::Rectangle : return "RECTANGLE";
+                case RecordType::Polygon : return "POLYGON";
+                case RecordType::PolygonWithHoles : return "POLYGON_WITH_HOLES";
+                case RecordType::Line : return "LINE";
+                case RecordType::Ray : return "RAY";
+                case RecordType::Mesh : return "MESH";
+                case RecordType::Polyline : return "POLYLINE";
+                default: return "N/A";
+            }
+        }
+    }
+
+    /**
+     * @brief Convert RecordType to the keyword that starts its object header
+     * @param type Record type
+     * @return The header keyword of the record type
+     */
+    std::string toString(const RecordType type) {
+        return std::string(keywordOf(type));
+    }
+
+    /**
+     * @brief Convert an object header keyword to its RecordType
+     * @param keyword First token of an object header
+     * @return The matching record type, RecordType::Unknown if there is none
+     */
+    RecordType toRecordType(std::string_view keyword) {
+        if (keyword == "POINT") return RecordType::Point;
+        if (keyword == "LINE_SEGMENT") return RecordType::Segment;
+        if (keyword == "CIRCLE") return RecordType::Circle;
+        if (keyword == "TRIANGLE") return RecordType::Triangle;
+        if (keyword == "RECTANGLE") return RecordType::Rectangle;
+        if (keyword == "POLYGON") return RecordType::Polygon;
+        if (keyword == "POLYGON_WITH_HOLES") return RecordType::PolygonWithHoles;
+        if (keyword == "LINE") return RecordType::Line;
+        if (keyword == "RAY") return RecordType::Ray;
+        if (keyword == "MESH") return RecordType::Mesh;
+        if (keyword == "POLYLINE") return RecordType::Polyline;
+        return RecordType::Unknown;
+    }
+
+    /**
+     * @brief The number of detail lines of a fixed-size object
+     * @param type Record type
+     * @return # of detail lines; 0 for POINT and LINE, and for the types whose header carries the count
+     */
+    std::size_t detailLength(const RecordType type) {
+        switch (type) {
+            case RecordType::Segment : return 2;
+            case RecordType::Circle : return 1;
+            case RecordType::Triangle : return 3;
+            case RecordType::Rectangle : return 2;
+            case RecordType::Ray : return 2;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Split a line into its space-separated tokens
+     * @param line Line without its newline; a trailing carriage return is dropped
+     * @param tokens Receives the tokens (views into line)
+     */
+    void splitTokens(std::string_view line, std::vector<std::string_view>& tokens) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        tokens.clear();
+        std::size_t pos = 0;
+        while (pos < line.size()) {
+            std::size_t end = line.find(' ', pos);
+            if (end == std::string_view::npos) end = line.size();
+            if (end > pos) tokens.push_back(line.substr(pos, end - pos));
+            pos = end + 1;
+        }
+    }
+
+    namespace {
+        // The number of numeric header fields in front of the style
+        std::size_t headerValueCount(const RecordType type) {
+            switch (type) {
+                case RecordType::Point : return 2;
+                case RecordType::Circle : return 1;
+                case RecordType::Line : return 3;
+                default: return 0;
+            }
+        }
+
+        bool parseNumber(std::string_view token, double& value) {
+            const char* last = token.data() + token.size();
+            auto res = std::from_chars(token.data(), last, value);
+            return res.ec == std::errc() && res.ptr == last;
+        }
+
+        bool parseNumber(std::string_view token, long long& value) {
+            const char* last = token.data() + token.size();
+            auto res = std::from_chars(token.data(), last, value);
+            return res.ec == std::errc() && res.ptr == last;
+        }
+
+        bool parseColor(const std::vector<std::string_view>& tokens, std::size_t first, Color& color) {
+            long long c[4];
+            for (int i = 0; i < 4; ++i) {
+                if (!parseNumber(tokens[first + i], c[i])) return false;
+            }
+            color = { (short)c[0], (short)c[1], (short)c[2], (short)c[3] };
+            return true;
+        }
+
+        /**
+         * @brief Parse "<boundaryColor> boundaryType [<interiorColor>]" starting at tokens[first]; missing style means default style
+         * @return false if the style is present but malformed
+         */
+        bool parseStyle(const std::vector<std::string_view>& tokens, std::size_t first, Style& style) {
+            style = Style();
+            const std::size_t num_tokens = tokens.size() - first;
+            if (num_tokens == 0) return true;
+            if (num_tokens != 5 && num_tokens != 9) return false;
+
+            long long btype;
+            if (!parseColor(tokens, first, style.boundaryColor)) return false;
+            if (!parseNumber(tokens[first + 4], btype)) return false;
+            style.boundaryType = static_cast<BoundaryType>(btype);
+            if (num_tokens == 9) {
+                return parseColor(tokens, first + 5, style.interiorColor);
+            }
+            style.interiorColor = style.boundaryColor;
+            return true;
+        }
+
+        // Largest vertex/hole count accepted in a header, guards against allocating for garbage counts
+        const long long MaxElementCount = 1LL << 32;
+
+        // True if tokens form a well-formed POLYGON header (count and style parse)
+        bool isPolygonHeader(const std::vector<std::string_view>& tokens) {
+            long long count = -1;
+            Style style;
+            return tokens.size() >= 2 && tokens[0] == "POLYGON" && parseNumber(tokens[1], count)
+                && count >= 0 && count <= MaxElementCount && parseStyle(tokens, 2, style);
+        }
+
+        /**
+         * @brief Parse the length token "@bytes/lines" of a length-prefixed header
+         * @return false if the token is malformed (e.g. the blank placeholder of a layer block that is still being written)
+         */
+        bool parseLength(std::string_view token, std::uint64_t& bytes, std::size_t& lines) {
+            const std::string_view length = token.substr(1);
+            const std::size_t slash = length.find('/');
+            long long num_bytes = -1, num_lines = -1;
+            if (slash == std::string_view::npos || !parseNumber(length.substr(0, slash), num_bytes)
+                || !parseNumber(length.substr(slash + 1), num_lines) || num_bytes < 0 || num_lines < 0) {
+                return false;
+            }
+            bytes = (std::uint64_t)num_bytes;
+            lines = (std::size_t)num_lines;
+            return true;
+        }
+
+        /**
+         * @brief Move a stream ahead by the length of a length-prefixed record or layer block, if that length is sound
+         * @param in Input stream, at the start of the bytes to skip
+         * @param bytes # of bytes to skip
+         * @param lines # of lines in these bytes
+         * @param corrupt Set if the length is corrupt
+         * @return false if in is left where it was: the stream is not seekable, or the length is corrupt (it does
+         * not end on a line start within the input, or does not agree with the line count)
+         */
+        bool seekAhead(std::istream& in, std::uint64_t bytes, std::size_t lines, bool& corrupt) {
+            corrupt = (bytes == 0) != (lines == 0);
+            if (corrupt) return false;
+            if (bytes == 0) return true;
+            const std::istream::pos_type here = in.tellg();
+            if (here == std::istream::pos_type(-1)) {
+                in.clear();
+                return false;
+            }
+            // The byte in front of the target is the newline that ends the last skipped line
+            const std::uint64_t limit = (std::uint64_t)std::numeric_limits<std::streamoff>::max() - (std::uint64_t)(std::streamoff)here;
+            corrupt = bytes > limit || !in.seekg(here + (std::streamoff)(bytes - 1)) || in.get() != '\n';
+            if (corrupt) {
+                in.clear();
+                in.seekg(here);
+            }
+            return !corrupt;
+        }
+
+        // True if the number of detail lines of a record type is fixed (see detailLength)
+        bool hasFixedLength(const RecordType type) {
+            return type != RecordType::Polygon && type != RecordType::PolygonWithHoles && type != RecordType::Mesh
+                && type != RecordType::Polyline && type != RecordType::Unknown;
+        }
+
+        // Name of a layer: the tokens of its "LAYER name..." line after the keyword (length token removed)
+        std::string layerName(const std::vector<std::string_view>& tokens) {
+            std::string name;
+            for (std::size_t i = 1; i < tokens.size(); ++i) {
+                if (i > 1) name += ' ';
+                name.append(tokens[i].data(), tokens[i].size());
+            }
+            return name;
+        }
+    }
+
+    /**
+     * @brief Create a record reader on an input stream
+     * @param in Input stream, positioned at the start of a line
+     * @param options Parse options (error budget)
+     * @param report Receives the diagnostics and record count
+     * @param startOffset Byte offset of the current position of in within the file
+     * @param startLine # of lines in front of the current position of in
+     * @param startLayer Layer of the records at the current position of in
+     */
+    RecordReader::RecordReader(std::istream& in, const ParseOptions& options, ParseReport& report,
+        std::uint64_t startOffset, std::size_t startLine, const std::string& startLayer)
+        : in(in), options(options), report(report), filtered(options.filter.active()),
+        currentLayer(startLayer), skippingLayer(!options.layers.empty() && options.layers.count(startLayer) == 0),
+        firstDiagnostic(report.diagnostics.size()), lineNo(startLine), lineStart(startOffset), nextLineStart(startOffset),
+        recordEnd(startOffset), recordEndLine(startLine) {
+    }
+
+    /**
+     * @brief Read the next line into the buffer and split it into tokens
+     * @return false at the end of input; with ParseOptions::pendingTail, an unterminated last line counts as the end of input
+     */
+    bool RecordReader::readLine() {
+        if (pushedBack) {
+            pushedBack = false;
+            return true;
+        }
+        if (!std::getline(in, buffer)) return false;
+        if (in.eof() && options.pendingTail) {
+            endedInRecord = true;
+            return false;
+        }
+
+        lineStart = nextLineStart;
+        nextLineStart += buffer.size() + (in.eof() ? 0 : 1);
+        ++lineNo;
+
+        splitTokens(buffer, tokens);
+
+        // Length-prefixed header: "... @bytes/lines" gives the size of the detail lines that follow
+        hasLength = false;
+        if (tokens.size() > 1 && tokens.back()[0] == '@') {
+            hasLength = parseLength(tokens.back(), detailBytes, detailLines);
+            tokens.pop_back();
+            const RecordType type = toRecordType(tokens[0]);
+            if (hasLength && !options.pendingTail && hasFixedLength(type) && detailLines != detailLength(type)) {
+                // A corrupt length is ignored; the record is read line by line
+                fail(tokens[0], "record length does not match its type");
+                hasLength = false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Skip the next bytes of input (the details of a length-prefixed record) with a single seek
+     * @param type Type token of the record (or "LAYER")
+     * @param bytes # of bytes to skip
+     * @param lines # of lines in these bytes
+     * @return false if nothing was skipped and the bytes have to be read line by line: the stream is not seekable
+     * (e.g. a MemoryBuffer), or the length is corrupt (a diagnostic has been recorded)
+     */
+    bool RecordReader::skipBytes(std::string_view type, std::uint64_t bytes, std::size_t lines) {
+        bool corrupt = false;
+        if (!seekAhead(in, bytes, lines, corrupt)) {
+            if (corrupt) {
+                fail(type, "record length points past the end of input or into a line");
+                hasLength = false;
+            }
+            return false;
+        }
+        nextLineStart += bytes;
+        lineNo += lines;
+        return true;
+    }
+
+    /**
+     * @brief Hand the current line back, so that the next readLine() returns it again
+     */
+    void RecordReader::unreadLine() {
+        pushedBack = true;
+    }
+
+    /**
+     * @brief Record a diagnostic for the current line and abort once the error budget is exceeded
+     * @param type Type token of the record being parsed
+     * @param reason Description of the problem
+     */
+    void RecordReader::fail(std::string_view type, const std::string& reason) {
+        if (endedInRecord && options.pendingTail) return;
+        report.diagnostics.push_back({ lineNo, lineStart, std::string(type), reason });
+        if (report.diagnostics.size() > options.errorBudget) {
+            report.aborted = true;
+        }
+    }
+
+    /**
+     * @brief Read the next valid record, skipping (and reporting) malformed ones.
+     * @param record Receives the record; its buffers are reused
+     * @return false at the end of input or once the error budget is exceeded
+     */
+    bool RecordReader::next(Record& record) {
+        while (!report.aborted) {
+            if (!readLine()) {
+                retractPending();
+                return false;
+            }
+            if (tokens.empty()) {
+                recordEnd = nextLineStart;
+                recordEndLine = lineNo;
+                continue;
+            }
+            if (tokens[0] == "LAYER") {
+                // Start of a layer block; its length covers the lines up to the next LAYER line
+                currentLayer = layerName(tokens);
+                skippingLayer = !options.layers.empty() && options.layers.count(currentLayer) == 0;
+                if (skippingLayer && hasLength && !options.pendingTail) {
+                    skipBytes(tokens[0], detailBytes, detailLines);
+                }
+                recordEnd = nextLineStart;
+                recordEndLine = lineNo;
+                continue;
+            }
+            if (skippingLayer) {
+                // A block without length is passed over line by line, without parsing its records
+                recordEnd = nextLineStart;
+                recordEndLine = lineNo;
+                continue;
+            }
+            if (tokens[0] == "REPEAT") {
+                // Annotation of a deduplicated export: the next object occurred n times
+                long long count = 0;
+                if (tokens.size() != 2 || !parseNumber(tokens[1], count) || count < 1) {
+                    fail(tokens[0], "invalid repeat count");
+                    count = 1;
+                }
+                // offset() stays in front of the annotation until its object is complete
+                repeat = (std::size_t)count;
+                continue;
+            }
+            if (tokens[0] == "ID") {
+                // Annotation of a reordered export: original position of the next object
+                long long position = -1;
+                if (tokens.size() != 2 || !parseNumber(tokens[1], position) || position < 0) {
+                    fail(tokens[0], "invalid object id");
+                    position = -1;
+                }
+                id = position < 0 ? NoRecordId : (std::uint64_t)position;
+                continue;
+            }
+
+            const RecordType type = toRecordType(tokens[0]);
+            const bool wanted = (options.recordTypes & typeBit(type)) != 0;
+            const std::uint64_t record_end = nextLineStart + detailBytes;
+            const std::size_t record_end_line = lineNo + detailLines;
+
+            bool ok = false;
+            const bool skipped = !wanted && hasLength && !options.pendingTail && type != RecordType::Unknown
+                && skipBytes(tokens[0], detailBytes, detailLines);
+            // skipBytes drops a corrupt length, so that the record is read line by line
+            const bool header_has_length = hasLength && !options.pendingTail;
+            if (!skipped) {
+                ok = parseRecord(record);
+                if (endedInRecord && options.pendingTail) {
+                    retractPending();
+                    return false;
+                }
+
+                // A malformed length-prefixed record is skipped as a whole
+                if (!ok && header_has_length && !endedInRecord && nextLineStart <= record_end
+                    && (pushedBack ? lineStart : nextLineStart) < record_end) {
+                    const bool pushed_back = pushedBack;
+                    pushedBack = false;
+                    if (!skipBytes(keywordOf(type), record_end - nextLineStart, record_end_line > lineNo ? record_end_line - lineNo : 0)) {
+                        // Resynchronize line by line instead
+                        pushedBack = pushed_back;
+                    }
+                }
+            }
+            if (!endedInRecord) {
+                recordEnd = pushedBack ? lineStart : nextLineStart;
+                recordEndLine = pushedBack ? lineNo - 1 : lineNo;
+            }
+            record.repeat = repeat;
+            record.id = id;
+            record.layer = currentLayer;
+            repeat = 1;
+            id = NoRecordId;
+            if (ok && wanted && (!filtered || (!rejected && options.filter.accept(record)))) {
+                ++report.records;
+                return true;
+            }
+        }
+        retractPending();
+        return false;
+    }
+
+    /**
+     * @brief Withdraw the diagnostics of the lines from offset() on if input may still be growing
+     * (ParseOptions::pendingTail): the next reader resumes at offset() and raises them again, once
+     */
+    void RecordReader::retractPending() {
+        if (!options.pendingTail) return;
+        std::size_t num_kept = report.diagnostics.size();
+        while (num_kept > firstDiagnostic && report.diagnostics[num_kept - 1].offset >= recordEnd) --num_kept;
+        if (num_kept == report.diagnostics.size()) return;
+        report.diagnostics.resize(num_kept);
+        report.aborted = report.diagnostics.size() > options.errorBudget;
+    }
+
+    /**
+     * @brief Parse the record whose header is the current line
+     * @param record Receives the record
+     * @return false if the record is malformed (a diagnostic has been recorded)
+     */
+    bool RecordReader::parseRecord(Record& record) {
+        record.type = toRecordType(tokens[0]);
+        record.values.clear();
+        record.points.clear();
+        record.rings.clear();
+        record.indices.clear();
+        record.faceSizes.clear();
+        record.line = lineNo;
+        record.offset = lineStart;
+        rejected = false;
+
+        if (record.type == RecordType::Unknown) {
+            fail(tokens[0], "unknown record type");
+            return false;
+        }
+        const std::string_view keyword = keywordOf(record.type);
+
+        if (record.type == RecordType::Polygon || record.type == RecordType::Polyline || record.type == RecordType::PolygonWithHoles) {
+            long long count = -1;
+            if (tokens.size() < 2 || !parseNumber(tokens[1], count) || count < 0 || count > MaxElementCount) {
+                fail(keyword, "invalid element count");
+                // The details of a broken polygon are POINT lines (and nested POLYGON lines of a POLYGON_WITH_HOLES);
+                // drop them rather than leaking them as top-level objects, but stop at the next valid header
+                while (readLine()) {
+                    const bool detail = !tokens.empty() && (tokens[0] == "POINT"
+                        || (record.type == RecordType::PolygonWithHoles && tokens[0] == "POLYGON" && !isPolygonHeader(tokens)));
+                    if (!detail) {
+                        unreadLine();
+                        break;
+                    }
+                }
+                return false;
+            }
+            if (record.type != RecordType::PolygonWithHoles) {
+                if (!parseStyle(tokens, 2, record.style)) {
+                    fail(keyword, "malformed style");
+                    return false;
+                }
+                if (rejectHeader(record, (std::size_t)count)) return true;
+                return parsePolygonBody(record, (std::size_t)count, keyword);
+            }
+
+            record.style = Style();
+            bool ok = true;
+            const std::size_t num_rings = (std::size_t)count + 1;
+            for (std::size_t ring = 0; ring < num_rings; ++ring) {
+                if (!readLine()) {
+                    endedInRecord = true;
+                    fail(keyword, "unexpected end of file");
+                    return false;
+                }
+                long long num_vertices = -1;
+                Style ring_style;
+                if (tokens.empty() || tokens[0] != "POLYGON") {
+                    if (!tokens.empty() && toRecordType(tokens[0]) != RecordType::Unknown) unreadLine();
+                    fail(keyword, "expected POLYGON ring " + std::to_string(ring));
+                    return false;
+                }
+                if (tokens.size() < 2 || !parseNumber(tokens[1], num_vertices) || num_vertices < 0 || num_vertices > MaxElementCount
+                    || !parseStyle(tokens, 2, ring_style)) {
+                    fail(keyword, "malformed header of POLYGON ring " + std::to_string(ring));
+                    return false;
+                }
+                if (ring == 0) record.style = ring_style;
+                record.rings.push_back({ (std::size_t)num_vertices, ring_style });
+                if (!parsePolygonBody(record, (std::size_t)num_vertices, keyword)) {
+                    if (pushedBack || endedInRecord) return false;
+                    ok = false;
+                }
+            }
+            return ok;
+        }
+
+        if (record.type == RecordType::Mesh) {
+            long long num_vertices = -1, num_faces = -1;
+            if (tokens.size() < 3 || !parseNumber(tokens[1], num_vertices) || !parseNumber(tokens[2], num_faces)
+                || num_vertices < 0 || num_faces < 0 || num_vertices > MaxElementCount || num_faces > MaxElementCount) {
+                fail(keyword, "invalid element count");
+                // Vertex and face lines start with a number; drop them up to the next header
+                while (readLine()) {
+                    if (tokens.empty() || toRecordType(tokens[0]) != RecordType::Unknown) {
+                        unreadLine();
+                        break;
+                    }
+                }
+                return false;
+            }
+            if (!parseStyle(tokens, 3, record.style)) {
+                fail(keyword, "malformed style");
+                return false;
+            }
+            if (rejectHeader(record, (std::size_t)num_vertices)) return true;
+            return parseMeshBody(record, (std::size_t)num_vertices, (std::size_t)num_faces);
+        }
+
+        const std::size_t num_values = headerValueCount(record.type);
+        if (tokens.size() < 1 + num_values) {
+            fail(keyword, "missing header fields");
+            return false;
+        }
+        for (std::size_t i = 0; i < num_values; ++i) {
+            double value;
+            if (!parseNumber(tokens[1 + i], value)) {
+                fail(keyword, "invalid number '" + std::string(tokens[1 + i]) + "'");
+                return false;
+            }
+            record.values.push_back(value);
+        }
+        if (!parseStyle(tokens, 1 + num_values, record.style)) {
+            fail(keyword, "malformed style");
+            return false;
+        }
+        if (rejectHeader(record, 0)) return true;
+
+        const std::size_t num_details = detailLength(record.type);
+        bool ok = true;
+        for (std::size_t i = 0; i < num_details; ++i) {
+            if (!parseDetailPoint(record, keyword)) {
+                if (pushedBack || endedInRecord) return false;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Check the header of the current record against the filter of the parse options
+     * @param record Record whose header has been parsed
+     * @param numVertices Vertex count of a POLYGON / MESH header
+     * @return true if the record is rejected and its details have been skipped (length-prefixed records only;
+     * the details of other rejected records are still parsed, to stay in sync)
+     */
+    bool RecordReader::rejectHeader(const Record& record, std::size_t numVertices) {
+        if (!filtered || options.filter.acceptHeader(record, numVertices)) return false;
+        rejected = true;
+        if (!hasLength || options.pendingTail) return false;
+        return skipBytes(keywordOf(record.type), detailBytes, detailLines);
+    }
+
+    /**
+     * @brief Parse the numVertices POINT lines of a polygon (or polygon ring)
+     * @return false if the body is malformed (a diagnostic has been recorded)
+     */
+    bool RecordReader::parsePolygonBody(Record& record, std::size_t numVertices, std::string_view type) {
+        bool ok = true;
+        for (std::size_t i = 0; i < numVertices; ++i) {
+            if (!parseDetailPoint(record, type)) {
+                if (pushedBack || endedInRecord) return false;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Parse a "POINT x y ..." detail line; the visual setting of detail points is ignored.
+     * A line that is not a POINT line is handed back, so that it can be parsed as the next header.
+     * @return false if the line is malformed (a diagnostic has been recorded)
+     */
+    bool RecordReader::parseDetailPoint(Record& record, std::string_view type) {
+        if (!readLine()) {
+            endedInRecord = true;
+            fail(type, "unexpected end of file");
+            return false;
+        }
+        if (tokens.empty() || tokens[0] != "POINT") {
+            unreadLine();
+            fail(type, "expected POINT detail line");
+            return false;
+        }
+
+        double x, y;
+        if (tokens.size() < 3 || !parseNumber(tokens[1], x) || !parseNumber(tokens[2], y)) {
+            fail(type, "malformed POINT detail line");
+            return false;
+        }
+        record.points.push_back({ x, y });
+        return true;
+    }
+
+    /**
+     * @brief Parse the "x y" vertex lines and the "numIndices index ..." face lines of a mesh
+     * @return false if the body is malformed (a diagnostic has been recorded)
+     */
+    bool RecordReader::parseMeshBody(Record& record, std::size_t numVertices, std::size_t numFaces) {
+        const std::string_view keyword = keywordOf(RecordType::Mesh);
+        bool ok = true;
+        for (std::size_t i = 0; i < numVertices + numFaces; ++i) {
+            if (!readLine()) {
+                endedInRecord = true;
+                fail(keyword, "unexpected end of file");
+                return false;
+            }
+            if (tokens.empty() || toRecordType(tokens[0]) != RecordType::Unknown) {
+                unreadLine();
+                fail(keyword, i < numVertices ? "expected vertex line" : "expected face line");
+                return false;
+            }
+
+            if (i < numVertices) {
+                double x, y;
+                if (tokens.size() != 2 || !parseNumber(tokens[0], x) || !parseNumber(tokens[1], y)) {
+                    fail(keyword, "malformed vertex line");
+                    ok = false;
+                    continue;
+                }
+                record.points.push_back({ x, y });
+                continue;
+            }
+
+            long long face_size = -1;
+            bool face_ok = parseNumber(tokens[0], face_size) && face_size >= 3 && tokens.size() == 1 + (std::size_t)face_size;
+            for (std::size_t j = 1; face_ok && j < tokens.size(); ++j) {
+                long long index = -1;
+                face_ok = parseNumber(tokens[j], index) && index >= 0 && (std::size_t)index < numVertices;
+                record.indices.push_back((std::size_t)index);
+            }
+            if (!face_ok) {
+                fail(keyword, "malformed face line");
+                ok = false;
+                continue;
+            }
+            record.faceSizes.push_back((std::size_t)face_size);
+        }
+        return ok;
+    }
+
+    namespace {
+        bool sameColor(const Color& a, const Color& b) {
+            return a.r == b.r && a.g == b.g && a.b == b.b && a.trans == b.trans;
+        }
+    }
+
+    bool RecordFilter::active() const {
+        return bounds || boundaryColor || interiorColor || minVertices > 0
+            || maxVertices < std::numeric_limits<std::size_t>::max()
+            || minRadius > 0 || maxRadius < std::numeric_limits<double>::infinity() || predicate;
+    }
+
+    /**
+     * @brief Check the predicates that only need the header of a record: style, vertex count, radius and point location
+     * @param rec Record with a parsed header (type, values, style)
+     * @param numVertices Vertex count of a POLYGON / MESH header (for other types ignored)
+     * @return false if the record is rejected
+     */
+    bool RecordFilter::acceptHeader(const Record& rec, std::size_t numVertices) const {
+        if (boundaryColor && !sameColor(rec.style.boundaryColor, *boundaryColor)) return false;
+        if (interiorColor && !sameColor(rec.style.interiorColor, *interiorColor)) return false;
+        switch (rec.type) {
+            case RecordType::Polygon :
+            case RecordType::Polyline :
+            case RecordType::Mesh :
+                return numVertices >= minVertices && numVertices <= maxVertices;
+            case RecordType::Circle :
+                return rec.values[0] >= minRadius && rec.values[0] <= maxRadius;
+            case RecordType::Point :
+                return !bounds || (rec.values[0] >= bounds->xmin() && rec.values[0] <= bounds->xmax()
+                    && rec.values[1] >= bounds->ymin() && rec.values[1] <= bounds->ymax());
+            default:
+                return true;
+        }
+    }
+
+    /**
+     * @brief Check all predicates on a complete record
+     * @param rec Parsed record
+     * @return false if the record is rejected
+     */
+    bool RecordFilter::accept(const Record& rec) const {
+        std::size_t num_vertices = rec.points.size();
+        if (rec.type == RecordType::PolygonWithHoles) {
+            num_vertices = rec.rings.empty() ? 0 : rec.rings[0].size;
+            if (num_vertices < minVertices || num_vertices > maxVertices) return false;
+        }
+        if (!acceptHeader(rec, num_vertices)) return false;
+
+        CGAL::Bbox_2 box;
+        if (bounds && rec.type != RecordType::Point && rec.type != RecordType::Ray && bboxOf(rec, box)) {
+            if (box.xmax() < bounds->xmin() || box.xmin() > bounds->xmax()
+                || box.ymax() < bounds->ymin() || box.ymin() > bounds->ymax()) {
+                return false;
+            }
+        }
+        return !predicate || predicate(rec);
+    }
+
+    /**
+     * @brief Bounding box of a record, computed from its raw coordinates
+     * @param rec Parsed record
+     * @param box Receives the bounding box
+     * @return false if the record has no vertices (LINE), box is then left unchanged
+     */
+    bool bboxOf(const Record& rec, CGAL::Bbox_2& box) {
+        if (rec.type == RecordType::Point) {
+            box = CGAL::Bbox_2(rec.values[0], rec.values[1], rec.values[0], rec.values[1]);
+            return true;
+        }
+        if (rec.points.empty()) return false;
+
+        double xmin = rec.points[0].x, xmax = xmin, ymin = rec.points[0].y, ymax = ymin;
+        for (const RawPoint& p : rec.points) {
+            xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+            ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+        }
+        // A circle extends by its radius around its center
+        const double margin = rec.type == RecordType::Circle ? rec.values[0] : 0;
+        box = CGAL::Bbox_2(xmin - margin, ymin - margin, xmax + margin, ymax + margin);
+        return true;
+    }
+
+    /**
+    * The follow section converts parsed records into CGAL objects.
+    * The record is expected to be of the matching type.
+    */
+
+    void fromRecord(const Record& rec, Point_2& p) {
+        p = Point_2(rec.values[0], rec.values[1]);
+    }
+
+    void fromRecord(const Record& rec, Segment_2& seg) {
+        seg = Segment_2(
+            Point_2(rec.points[0].x, rec.points[0].y), Point_2(rec.points[1].x, rec.points[1].y)
+        );
+    }
+
+    void fromRecord(const Record& rec, Circle_2& circ) {
+        const double radius = rec.values[0];
+        circ = Circle_2(Point_2(rec.points[0].x, rec.points[0].y), radius * radius);
+    }
+
+    void fromRecord(const Record& rec, Triangle_2& tri) {
+        tri = Triangle_2(
+            Point_2(rec.points[0].x, rec.points[0].y),
+            Point_2(rec.points[1].x, rec.points[1].y),
+            Point_2(rec.points[2].x, rec.points[2].y)
+        );
+    }
+
+    void fromRecord(const Record& rec, Iso_rectangle_2& rect) {
+        rect = Iso_rectangle_2(
+            Point_2(rec.points[0].x, rec.points[0].y), Point_2(rec.points[1].x, rec.points[1].y)
+        );
+    }
+
+    void fromRecord(const Record& rec, Polygon_2& poly) {
+        poly = Polygon_2();
+        for (const RawPoint& p : rec.points) {
+            poly.push_back(Point_2(p.x, p.y));
+        }
+    }
+
+    void fromRecord(const Record& rec, Polygon_with_holes_2& poly_w_h) {
+        std::vector<Polygon_2> rings(rec.rings.size());
+        std::size_t vertex = 0;
+        for (std::size_t ring = 0; ring < rec.rings.size(); ++ring) {
+            for (std::size_t i = 0; i < rec.rings[ring].size; ++i, ++vertex) {
+                rings[ring].push_back(Point_2(rec.points[vertex].x, rec.points[vertex].y));
+            }
+        }
+        poly_w_h = rings.empty() ? Polygon_with_holes_2() : Polygon_with_holes_2(rings[0], rings.begin() + 1, rings.end());
+    }
+
+    void fromRecord(const Record& rec, Line_2& line) {
+        line = Line_2(rec.values[0], rec.values[1], rec.values[2]);
+    }
+
+    void fromRecord(const Record& rec, Ray_2& ray) {
+        ray = Ray_2(
+            Point_2(rec.points[0].x, rec.points[0].y), Point_2(rec.points[1].x, rec.points[1].y)
+        );
+    }
+
+    /**
+     * @brief Append the CGAL object of a record to the vector of its type
+     * @param rec Parsed record
+     */
+    void GeometrySet::add(const Record& rec) {
+        switch (rec.type) {
+            case RecordType::Point : points.emplace_back(); fromRecord(rec, points.back()); break;
+            case RecordType::Segment : segments.emplace_back(); fromRecord(rec, segments.back()); break;
+            case RecordType::Circle : circles.emplace_back(); fromRecord(rec, circles.back()); break;
+            case RecordType::Triangle : triangles.emplace_back(); fromRecord(rec, triangles.back()); break;
+            case RecordType::Rectangle : rectangles.emplace_back(); fromRecord(rec, rectangles.back()); break;
+            case RecordType::Polygon : polygons.emplace_back(); fromRecord(rec, polygons.back()); break;
+            case RecordType::PolygonWithHoles : polygonsWithHoles.emplace_back(); fromRecord(rec, polygonsWithHoles.back()); break;
+            case RecordType::Line : lines.emplace_back(); fromRecord(rec, lines.back()); break;
+            case RecordType::Ray : rays.emplace_back(); fromRecord(rec, rays.back()); break;
+            case RecordType::Mesh : meshes.emplace_back(); fromRecord(rec, meshes.back()); break;
+            case RecordType::Polyline : polylines.emplace_back(); fromRecord(rec, polylines.back()); break;
+            default: break;
+        }
+    }
+
+    /**
+     * @brief Total number of objects of all types
+     */
+    std::size_t GeometrySet::size() const {
+        return points.size() + segments.size() + circles.size() + triangles.size() + rectangles.size()
+            + polygons.size() + polygonsWithHoles.size() + lines.size() + rays.size() + meshes.size() + polylines.size();
+    }
+
+    /**
+     * @brief List the layers of a file. Only LAYER lines are parsed; the blocks of length-prefixed layers are
+     * skipped with one seek each, the lines of other blocks are only checked for the LAYER keyword.
+     * @param filename Target file
+     * @param report Receives a diagnostic if the file cannot be opened
+     * @return Layer names in the order of their first block; "" if there are objects in front of the first LAYER line
+     */
+    std::vector<std::string> getLayers(const std::string& filename, ParseReport& report) {
+        std::vector<std::string> layers;
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            report.diagnostics.push_back({ 0, 0, "", "cannot open file '" + filename + "'" });
+            return layers;
+        }
+
+        std::set<std::string> known;
+        std::string line;
+        std::vector<std::string_view> tokens;
+        std::size_t line_no = 0;
+        std::uint64_t line_start = 0, next_line_start = 0;
+        while (std::getline(in, line)) {
+            line_start = next_line_start;
+            next_line_start += line.size() + (in.eof() ? 0 : 1);
+            ++line_no;
+            splitTokens(line, tokens);
+            if (tokens.empty()) continue;
+            if (tokens[0] != "LAYER") {
+                if (known.empty()) {
+                    known.insert("");
+                    layers.push_back("");
+                }
+                continue;
+            }
+
+            std::uint64_t bytes = 0;
+            std::size_t lines = 0;
+            bool has_length = false;
+            if (tokens.size() > 1 && tokens.back()[0] == '@') {
+                has_length = parseLength(tokens.back(), bytes, lines);
+                tokens.pop_back();
+            }
+            const std::string name = layerName(tokens);
+            if (known.insert(name).second) layers.push_back(name);
+            bool corrupt = false;
+            if (has_length && seekAhead(in, bytes, lines, corrupt)) {
+                next_line_start += bytes;
+                line_no += lines;
+            }
+            else if (corrupt) {
+                // Read the block line by line instead
+                report.diagnostics.push_back({ line_no, line_start, "LAYER", "record length points past the end of input or into a line" });
+            }
+        }
+        return layers;
+    }
+
+    /**
+     * @brief Retrieve the objects of all types from target file in a single pass, without throwing
+     * @param filename Target file
+     * @param options Parse options
+     * @param report Receives the diagnostics
+     * @return All objects of the file, grouped by type
+     */
+    GeometrySet getGeometry(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        GeometrySet geometry;
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            report.diagnostics.push_back({ 0, 0, "", "cannot open file '" + filename + "'" });
+            return geometry;
+        }
+
+        RecordReader reader(in, options, report);
+        Record rec;
+        while (reader.next(rec)) {
+            geometry.add(rec);
+        }
+        return geometry;
+    }
+
+    void fromRecord(const Record& rec, Mesh_2& mesh) {
+        mesh.vertices.clear();
+        mesh.vertices.reserve(rec.points.size());
+        for (const RawPoint& p : rec.points) {
+            mesh.vertices.push_back(Point_2(p.x, p.y));
+        }
+        mesh.indices = rec.indices;
+        mesh.faceSizes = rec.faceSizes;
+    }
+
+    void fromRecord(const Record& rec, Polyline_2& polyline) {
+        polyline.vertices.clear();
+        polyline.vertices.reserve(rec.points.size());
+        for (const RawPoint& p : rec.points) {
+            polyline.vertices.push_back(Point_2(p.x, p.y));
+        }
+    }
+
+    namespace {
+        template <class Object>
+        void collect(const Record& rec, const RecordType type, std::vector<Object>& objs) {
+            if (rec.type == type) {
+                objs.emplace_back();
+                fromRecord(rec, objs.back());
+            }
+        }
+
+        // Triangles are also read from the triangular faces of meshes
+        void collect(const Record& rec, const RecordType type, std::vector<Triangle_2>& tris) {
+            if (rec.type == RecordType::Mesh) {
+                Mesh_2 mesh;
+                fromRecord(rec, mesh);
+                std::vector<Triangle_2> mesh_tris = toTriangles(mesh);
+                tris.insert(tris.end(), mesh_tris.begin(), mesh_tris.end());
+            }
+            else if (rec.type == type) {
+                tris.emplace_back();
+                fromRecord(rec, tris.back());
+            }
+        }
+
+        // Segments are also read from polylines
+        void collect(const Record& rec, const RecordType type, std::vector<Segment_2>& segs) {
+            if (rec.type == RecordType::Polyline) {
+                for (std::size_t i = 1; i < rec.points.size(); ++i) {
+                    segs.push_back(Segment_2(
+                        Point_2(rec.points[i - 1].x, rec.points[i - 1].y), Point_2(rec.points[i].x, rec.points[i].y)
+                    ));
+                }
+            }
+            else if (rec.type == type) {
+                segs.emplace_back();
+                fromRecord(rec, segs.back());
+            }
+        }
+
+        /**
+         * @brief Collect all objects of one record type from a file without throwing
+         * @param filename Target file
+         * @param type Record type to collect
+         * @param options Parse options
+         * @param report Receives the diagnostics
+         * @return A vector of the objects
+         */
+        template <class Object>
+        std::vector<Object> readObjects(const std::string& filename, const RecordType type, const ParseOptions& options, ParseReport& report) {
+            std::vector<Object> objs;
+            std::ifstream in(filename, std::ios::binary);
+            if (!in) {
+                report.diagnostics.push_back({ 0, 0, "", "cannot open file '" + filename + "'" });
+                return objs;
+            }
+
+            ParseOptions type_options = options;
+            type_options.recordTypes &= typeBit(type)
+                | (type == RecordType::Triangle ? typeBit(RecordType::Mesh) : 0)
+                | (type == RecordType::Segment ? typeBit(RecordType::Polyline) : 0);
+            RecordReader reader(in, type_options, report);
+            Record rec;
+            while (reader.next(rec)) {
+                collect(rec, type, objs);
+            }
+            return objs;
+        }
+    }
+
+    std::vector<Point_2> getPoints(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Point_2>(filename, RecordType::Point, options, report);
+    }
+
+    std::vector<Line_2> getLines(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Line_2>(filename, RecordType::Line, options, report);
+    }
+
+    std::vector<Circle_2> getCircles(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Circle_2>(filename, RecordType::Circle, options, report);
+    }
+
+    std::vector<Iso_rectangle_2> getRectangles(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Iso_rectangle_2>(filename, RecordType::Rectangle, options, report);
+    }
+
+    std::vector<Triangle_2> getTriangles(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Triangle_2>(filename, RecordType::Triangle, options, report);
+    }
+
+    std::vector<Segment_2> getSegments(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Segment_2>(filename, RecordType::Segment, options, report);
+    }
+
+    std::vector<Ray_2> getRays(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Ray_2>(filename, RecordType::Ray, options, report);
+    }
+
+    std::vector<Polygon_2> getPolygons(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Polygon_2>(filename, RecordType::Polygon, options, report);
+    }
+
+    std::vector<Polygon_with_holes_2> getPolygonsWithHoles(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Polygon_with_holes_2>(filename, RecordType::PolygonWithHoles, options, report);
+    }
+
+    std::vector<Mesh_2> getMeshes(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Mesh_2>(filename, RecordType::Mesh, options, report);
+    }
+
+    std::vector<Polyline_2> getPolylines(const std::string& filename, const ParseOptions& options, ParseReport& report) {
+        return readObjects<Polyline_2>(filename, RecordType::Polyline, options, report);
+    }
+}
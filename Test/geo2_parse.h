@@ -0,0 +1,255 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <set>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "geo2_util.h"
+
+namespace Geo2Util {
+    // Object types that can appear as a record in a geometry file
+    enum class RecordType : short {
+        Point = 0,
+        Segment,
+        Circle,
+        Triangle,
+        Rectangle,
+        Polygon,
+        PolygonWithHoles,
+        Line,
+        Ray,
+        Mesh,
+        Polyline,
+        Unknown
+    };
+
+    // Bit of a record type in ParseOptions::recordTypes
+    inline std::uint32_t typeBit(const RecordType type) {
+        return 1u << (unsigned)type;
+    }
+
+    // Visual setting carried by an object header
+    struct Style {
+        Color boundaryColor = DefaultBoundaryColor;
+        BoundaryType boundaryType = DefaultBoundaryType;
+        Color interiorColor = DefaultInteriorColor;
+    };
+
+    // Vertex of an object detail line, before any CGAL object is built
+    struct RawPoint {
+        double x;
+        double y;
+    };
+
+    // One ring of a POLYGON_WITH_HOLES record (outer boundary first, then holes)
+    struct Ring {
+        std::size_t size = 0;
+        Style style;
+    };
+
+    // Record::id of records that were not written with an "ID n" line
+    const std::uint64_t NoRecordId = std::numeric_limits<std::uint64_t>::max();
+
+    // A fully parsed object record (header + details) of a geometry file
+    struct Record {
+        RecordType type = RecordType::Unknown;
+        std::vector<double> values;     // numeric header fields in front of the style (x y | radius | a b c)
+        Style style;
+        std::vector<RawPoint> points;   // vertices of the detail lines, in file order
+        std::vector<Ring> rings;        // POLYGON_WITH_HOLES only; sizes sum up to points.size()
+        std::vector<std::size_t> indices;   // MESH only: vertex indices (into points) of all faces
+        std::vector<std::size_t> faceSizes; // MESH only: # of vertices of each face
+        std::size_t line = 0;           // 1-based line number of the header
+        std::uint64_t offset = 0;       // byte offset of the header
+        std::size_t repeat = 1;         // # of occurrences, from a preceding "REPEAT n" line of a deduplicated export
+        std::uint64_t id = NoRecordId;  // position of the object before a reordering export, from a preceding "ID n" line
+        std::string layer;              // name of the enclosing "LAYER" block; "" before the first one
+    };
+
+    // A problem found while parsing, reported instead of thrown
+    struct ParseDiagnostic {
+        std::size_t line = 0;           // 1-based line number of the offending line
+        std::uint64_t offset = 0;       // byte offset of the offending line
+        std::string recordType;         // type token of the record being parsed ("" if none)
+        std::string reason;
+    };
+
+    // Predicates on parsed records, checked before any CGAL object is built (see ParseOptions::filter)
+    struct RecordFilter {
+        // Keep objects whose bounding box intersects bounds; LINE and RAY objects are unbounded and always kept
+        std::optional<Iso_rectangle_2> bounds;
+        // Keep objects of this boundary / interior color (of the outer boundary for POLYGON_WITH_HOLES)
+        std::optional<Color> boundaryColor;
+        std::optional<Color> interiorColor;
+        // Vertex count range of POLYGON / POLYLINE objects (outer boundary of POLYGON_WITH_HOLES, vertex table of MESH)
+        std::size_t minVertices = 0;
+        std::size_t maxVertices = std::numeric_limits<std::size_t>::max();
+        // Radius range of CIRCLE objects
+        double minRadius = 0;
+        double maxRadius = std::numeric_limits<double>::infinity();
+        // Custom predicate, checked after all others
+        std::function<bool(const Record&)> predicate;
+
+        // True if any predicate is set
+        bool active() const;
+        // Checks that only need the header of a record; numVertices: vertex count of POLYGON / POLYLINE / MESH headers
+        bool acceptHeader(const Record& rec, std::size_t numVertices) const;
+        // All checks, on a complete record
+        bool accept(const Record& rec) const;
+    };
+
+    struct ParseOptions {
+        // Parsing is aborted as soon as more than errorBudget diagnostics have been collected
+        std::size_t errorBudget = std::numeric_limits<std::size_t>::max();
+        // Input may still be growing: a record cut off by the end of input is left unread instead of being reported
+        bool pendingTail = false;
+        // Types of the records to return (typeBit(type) | ...); other records are skipped, with a single
+        // seek if their header carries a length (see ExportOptions::lengthPrefixed)
+        std::uint32_t recordTypes = ~0u;
+        // Records failing the filter are dropped; length-prefixed ones are skipped right after their header
+        RecordFilter filter;
+        // Names of the layers to read ("" is the unnamed layer in front of the first LAYER line); empty reads all.
+        // Other layer blocks are skipped with a single seek if their LAYER line carries a length.
+        std::set<std::string> layers;
+    };
+
+    struct ParseReport {
+        std::vector<ParseDiagnostic> diagnostics;
+        std::size_t records = 0;        // # of valid records returned
+        bool aborted = false;           // true if the error budget was exceeded
+    };
+
+    // Keyword and type conversion of record headers
+    std::string toString(const RecordType type);
+    RecordType toRecordType(std::string_view keyword);
+    // # of detail lines of fixed-size records (0 for POINT, LINE and the types whose header carries the count)
+    std::size_t detailLength(const RecordType type);
+    // Split a line into space-separated tokens (a trailing '\r' is dropped)
+    void splitTokens(std::string_view line, std::vector<std::string_view>& tokens);
+
+    /**
+     * Sequential, non-throwing reader of the records of a geometry file.
+     * Malformed records are reported to the ParseReport and skipped; reading
+     * resynchronizes at the next line that is a valid object header.
+     */
+    class RecordReader {
+    public:
+        // startOffset/startLine/startLayer: position of in within the file, for resuming in the middle of a file
+        RecordReader(std::istream& in, const ParseOptions& options, ParseReport& report,
+            std::uint64_t startOffset = 0, std::size_t startLine = 0, const std::string& startLayer = std::string());
+
+        // Read the next valid record; false at the end of input or once the error budget is exceeded
+        bool next(Record& record);
+
+        // Byte offset just past the last complete record that has been returned
+        std::uint64_t offset() const { return recordEnd; }
+        // # of lines in front of offset()
+        std::size_t line() const { return recordEndLine; }
+        // True if input ended in the middle of a line or record (e.g. a file that is still being written)
+        bool truncated() const { return endedInRecord; }
+        // Layer of the records at offset()
+        const std::string& layer() const { return currentLayer; }
+
+    private:
+        bool readLine();
+        void unreadLine();
+        bool parseRecord(Record& record);
+        bool parsePolygonBody(Record& record, std::size_t numVertices, std::string_view type);
+        bool parseDetailPoint(Record& record, std::string_view type);
+        bool parseMeshBody(Record& record, std::size_t numVertices, std::size_t numFaces);
+        bool rejectHeader(const Record& record, std::size_t numVertices);
+        bool skipBytes(std::string_view type, std::uint64_t bytes, std::size_t lines);
+        void fail(std::string_view type, const std::string& reason);
+        void retractPending();
+
+        std::istream& in;
+        const ParseOptions& options;
+        ParseReport& report;
+        const bool filtered;            // options.filter is active
+        bool rejected = false;          // the current record failed the header checks of the filter
+        std::string currentLayer;
+        bool skippingLayer = false;     // the current layer is not in options.layers
+        const std::size_t firstDiagnostic;  // size of report.diagnostics when the reader was created
+
+        std::string buffer;
+        std::vector<std::string_view> tokens;
+        bool hasLength = false;         // the current line ends with a "@bytes/lines" token
+        std::uint64_t detailBytes = 0;
+        std::size_t detailLines = 0;
+        bool pushedBack = false;
+        bool endedInRecord = false;
+        std::size_t lineNo = 0;
+        std::uint64_t lineStart = 0;
+        std::uint64_t nextLineStart = 0;
+        std::uint64_t recordEnd = 0;
+        std::size_t recordEndLine = 0;
+        std::size_t repeat = 1;
+        std::uint64_t id = NoRecordId;
+    };
+
+    // Read-only stream buffer over text in memory, so that it can be parsed without copying
+    struct MemoryBuffer : std::streambuf {
+        MemoryBuffer(const char* first, const char* last) {
+            setg(const_cast<char*>(first), const_cast<char*>(first), const_cast<char*>(last));
+        }
+    };
+
+    // Build CGAL objects from parsed records
+    void fromRecord(const Record& rec, Point_2& p);
+    void fromRecord(const Record& rec, Segment_2& seg);
+    void fromRecord(const Record& rec, Circle_2& circ);
+    void fromRecord(const Record& rec, Triangle_2& tri);
+    void fromRecord(const Record& rec, Iso_rectangle_2& rect);
+    void fromRecord(const Record& rec, Polygon_2& poly);
+    void fromRecord(const Record& rec, Polygon_with_holes_2& poly_w_h);
+    void fromRecord(const Record& rec, Line_2& line);
+    void fromRecord(const Record& rec, Ray_2& ray);
+    void fromRecord(const Record& rec, Mesh_2& mesh);
+    void fromRecord(const Record& rec, Polyline_2& polyline);
+
+    // Bounding box of the vertices of a record (of a CIRCLE extended by its radius); false for a record without vertices (LINE)
+    bool bboxOf(const Record& rec, CGAL::Bbox_2& box);
+
+    // Objects of all types read from a file (or from a part of it)
+    struct GeometrySet {
+        std::vector<Point_2> points;
+        std::vector<Segment_2> segments;
+        std::vector<Circle_2> circles;
+        std::vector<Triangle_2> triangles;
+        std::vector<Iso_rectangle_2> rectangles;
+        std::vector<Polygon_2> polygons;
+        std::vector<Polygon_with_holes_2> polygonsWithHoles;
+        std::vector<Line_2> lines;
+        std::vector<Ray_2> rays;
+        std::vector<Mesh_2> meshes;
+        std::vector<Polyline_2> polylines;
+
+        void add(const Record& rec);
+        std::size_t size() const;
+    };
+
+    // Names of the layers of a file, in the order of their first block (reading only the LAYER lines of length-prefixed blocks)
+    std::vector<std::string> getLayers(const std::string& filename, ParseReport& report);
+
+    // Non-throwing import of all object types in one pass
+    GeometrySet getGeometry(const std::string& filename, const ParseOptions& options, ParseReport& report);
+
+    // Non-throwing import; malformed records are reported in report instead of raising exceptions
+    std::vector<Point_2> getPoints(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Line_2> getLines(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Circle_2> getCircles(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Iso_rectangle_2> getRectangles(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Triangle_2> getTriangles(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Segment_2> getSegments(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Ray_2> getRays(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Polygon_2> getPolygons(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Polygon_with_holes_2> getPolygonsWithHoles(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Mesh_2> getMeshes(const std::string& filename, const ParseOptions& options, ParseReport& report);
+    std::vector<Polyline_2> getPolylines(const std::string& filename, const ParseOptions& options, ParseReport& report);
+}
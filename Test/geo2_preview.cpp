@@ -0,0 +1,318 @@
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "geo2_preview.h"
+#include "geo2_internal.h"
+
+namespace Geo2Util {
+    namespace {
+        namespace fs = std::filesystem;
+        using internal::ByteOrderMark;
+
+        const char IndexMagic[8] = { 'G', 'E', 'O', '2', 'I', 'D', 'X', '\0' };
+        const std::uint32_t IndexVersion = 1;
+
+        // With spatial coverage, the cells are filled from this many times budget random candidates
+        const std::size_t CoverageOversampling = 4;
+
+        struct IndexHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            std::uint64_t sourceSize;
+            std::int64_t sourceTime;
+            std::uint64_t stride;
+            std::uint64_t records;
+            std::uint64_t entries;
+        };
+
+        // Start of every stride-th record: byte offset of its header and # of lines in front of it
+        struct IndexEntry {
+            std::uint64_t offset;
+            std::uint64_t line;
+        };
+
+        bool sourceState(const std::string& filename, std::uint64_t& size, std::int64_t& time) {
+            std::error_code ec;
+            size = (std::uint64_t)fs::file_size(filename, ec);
+            if (ec) return false;
+            time = (std::int64_t)fs::last_write_time(filename, ec).time_since_epoch().count();
+            return !ec;
+        }
+
+        template <class T>
+        bool readRaw(std::istream& in, T& value) {
+            return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        }
+
+        // Uniform random sample of a stream of records (Algorithm R)
+        class Reservoir {
+        public:
+            Reservoir(std::size_t capacity, std::mt19937_64& rng) : capacity(capacity), rng(rng) {
+                items.reserve(std::min<std::size_t>(capacity, 1 << 16));
+            }
+
+            void offer(const Record& rec) {
+                ++seen;
+                if (items.size() < capacity) {
+                    items.push_back(rec);
+                    return;
+                }
+                const std::uint64_t slot = std::uniform_int_distribution<std::uint64_t>(0, seen - 1)(rng);
+                if (slot < capacity) items[(std::size_t)slot] = rec;
+            }
+
+            std::vector<Record> items;
+
+        private:
+            std::size_t capacity;
+            std::uint64_t seen = 0;
+            std::mt19937_64& rng;
+        };
+
+        /**
+         * @brief Reservoir-sample the records of a whole file
+         */
+        std::vector<Record> sampleByScan(std::ifstream& in, std::size_t count, std::mt19937_64& rng,
+            const ParseOptions& options, ParseReport& report) {
+            Reservoir reservoir(count, rng);
+            RecordReader reader(in, options, report);
+            Record rec;
+            while (reader.next(rec)) {
+                reservoir.offer(rec);
+            }
+            return reservoir.items;
+        }
+
+        /**
+         * @brief Sample the records of a file through its record index: the index entries are split into
+         * count (or fewer) strata, and a random chunk of stride records of each stratum is reservoir-sampled
+         * @return false if there is no up-to-date index, if only some layers are wanted (the index entries
+         * do not record the layer they are in), or if records are filtered (the strata would hold unknown
+         * numbers of matching records, so the sample would fall short of count)
+         */
+        bool sampleByIndex(const std::string& filename, std::ifstream& in, std::size_t count, std::mt19937_64& rng,
+            const ParseOptions& options, ParseReport& report, std::vector<Record>& sample) {
+            if (!options.layers.empty() || options.filter.active()) return false;
+            std::ifstream index(indexPath(filename), std::ios::binary);
+            IndexHeader header;
+            std::uint64_t size = 0;
+            std::int64_t time = 0;
+            if (!index || !readRaw(index, header) || !sourceState(filename, size, time)) return false;
+            if (!std::equal(IndexMagic, IndexMagic + sizeof(IndexMagic), header.magic) || header.version != IndexVersion
+                || header.byteOrder != ByteOrderMark || header.sourceSize != size || header.sourceTime != time
+                || header.entries == 0) {
+                return false;
+            }
+
+            const std::uint64_t strata = std::min<std::uint64_t>(count, header.entries);
+            Record rec;
+            for (std::uint64_t stratum = 0; stratum < strata; ++stratum) {
+                const std::uint64_t first = header.entries * stratum / strata;
+                const std::uint64_t last = header.entries * (stratum + 1) / strata;
+                const std::uint64_t entry = std::uniform_int_distribution<std::uint64_t>(first, last - 1)(rng);
+                // samples per stratum, so that they add up to count
+                const std::size_t quota = (std::size_t)(count * (stratum + 1) / strata - count * stratum / strata);
+
+                IndexEntry chunk, next = { std::numeric_limits<std::uint64_t>::max(), 0 };
+                index.clear();
+                index.seekg((std::streamoff)(sizeof(IndexHeader) + entry * sizeof(IndexEntry)));
+                if (!readRaw(index, chunk)) return false;
+                if (entry + 1 < header.entries) readRaw(index, next);
+
+                in.clear();
+                in.seekg((std::streamoff)chunk.offset);
+                RecordReader reader(in, options, report, chunk.offset, (std::size_t)chunk.line);
+                if (quota == 1 && options.recordTypes == ParseOptions().recordTypes) {
+                    // The chunk holds a known # of records: read up to a random one instead of the whole chunk
+                    const std::uint64_t chunk_records = entry + 1 < header.entries
+                        ? header.stride : header.records - entry * header.stride;
+                    std::uint64_t target = std::uniform_int_distribution<std::uint64_t>(0, chunk_records - 1)(rng);
+                    while (reader.next(rec) && rec.offset < next.offset) {
+                        if (target-- == 0) {
+                            sample.push_back(rec);
+                            break;
+                        }
+                    }
+                }
+                else {
+                    Reservoir reservoir(quota, rng);
+                    while (reader.next(rec) && rec.offset < next.offset) {
+                        reservoir.offer(rec);
+                    }
+                    sample.insert(sample.end(), reservoir.items.begin(), reservoir.items.end());
+                }
+                if (report.aborted) break;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Center of the bounding box of a record
+         * @return false for records without an extent (LINE)
+         */
+        bool centerOf(const Record& rec, double& x, double& y) {
+            CGAL::Bbox_2 box;
+            if (!bboxOf(rec, box)) return false;
+            x = (box.xmin() + box.xmax()) / 2;
+            y = (box.ymin() + box.ymax()) / 2;
+            return true;
+        }
+
+        /**
+         * @brief Pick count of the candidates spread over a grid of about count cells: the cells take turns
+         * in giving up one random candidate each, so sparse regions are represented as well as dense ones
+         */
+        std::vector<Record> coverGrid(std::vector<Record>& candidates, std::size_t count, std::mt19937_64& rng) {
+            if (candidates.size() <= count) return std::move(candidates);
+            std::shuffle(candidates.begin(), candidates.end(), rng);
+
+            double xmin = std::numeric_limits<double>::max(), ymin = xmin;
+            double xmax = std::numeric_limits<double>::lowest(), ymax = xmax;
+            std::vector<double> xs(candidates.size()), ys(candidates.size());
+            std::vector<bool> located(candidates.size());
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                located[i] = centerOf(candidates[i], xs[i], ys[i]);
+                if (!located[i]) continue;
+                xmin = std::min(xmin, xs[i]); xmax = std::max(xmax, xs[i]);
+                ymin = std::min(ymin, ys[i]); ymax = std::max(ymax, ys[i]);
+            }
+
+            const std::size_t side = std::max<std::size_t>(1, (std::size_t)std::ceil(std::sqrt((double)count)));
+            const double width = xmax > xmin ? xmax - xmin : 1;
+            const double height = ymax > ymin ? ymax - ymin : 1;
+            std::vector<std::vector<std::size_t>> cells(side * side + 1); // last cell: records without extent
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                std::size_t cell = side * side;
+                if (located[i]) {
+                    const std::size_t column = std::min(side - 1, (std::size_t)((xs[i] - xmin) / width * side));
+                    const std::size_t row = std::min(side - 1, (std::size_t)((ys[i] - ymin) / height * side));
+                    cell = row * side + column;
+                }
+                cells[cell].push_back(i);
+            }
+
+            std::vector<Record> picked;
+            picked.reserve(count);
+            for (std::size_t round = 0; picked.size() < count; ++round) {
+                for (const std::vector<std::size_t>& cell : cells) {
+                    if (round < cell.size() && picked.size() < count) picked.push_back(std::move(candidates[cell[round]]));
+                }
+            }
+            return picked;
+        }
+    }
+
+    /**
+     * @brief Path of the record index of a file ("<file>.geo2idx")
+     * @param filename Target file
+     * @return Path of the index (which may not exist)
+     */
+    std::string indexPath(const std::string& filename) {
+        return filename + ".geo2idx";
+    }
+
+    /**
+     * @brief Scan a file and write its record index, which lets getPreview seek to records instead of reading
+     * the whole file. The index is tied to the size and modification time of the file and ignored once they change.
+     * @param filename Target file
+     * @param stride Every stride-th record is indexed; the index is about 16 / stride bytes per record
+     * @return false if the file cannot be read, changed during the scan, or the index cannot be written
+     */
+    bool buildIndex(const std::string& filename, std::size_t stride) {
+        std::uint64_t size = 0;
+        std::int64_t time = 0;
+        std::ifstream in(filename, std::ios::binary);
+        if (!in || !sourceState(filename, size, time)) return false;
+        stride = std::max<std::size_t>(stride, 1);
+
+        std::vector<IndexEntry> entries;
+        const ParseOptions options;
+        ParseReport report;
+        RecordReader reader(in, options, report);
+        Record rec;
+        while (reader.next(rec)) {
+            if ((report.records - 1) % stride == 0) entries.push_back({ rec.offset, (std::uint64_t)rec.line - 1 });
+        }
+
+        std::uint64_t scanned_size = 0;
+        std::int64_t scanned_time = 0;
+        if (!sourceState(filename, scanned_size, scanned_time) || scanned_size != size || scanned_time != time) return false;
+
+        IndexHeader header = {};
+        std::copy(IndexMagic, IndexMagic + sizeof(IndexMagic), header.magic);
+        header.version = IndexVersion;
+        header.byteOrder = ByteOrderMark;
+        header.sourceSize = size;
+        header.sourceTime = time;
+        header.stride = stride;
+        header.records = report.records;
+        header.entries = entries.size();
+
+        // Written under a temporary name and renamed, so that readers never see a partial index
+        const std::string index = indexPath(filename);
+        const std::string temporary = index + ".tmp"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(IndexEntry)));
+        out.close();
+
+        std::error_code ec;
+        if (!out.fail()) fs::rename(temporary, index, ec);
+        const bool written = !out.fail() && !ec;
+        fs::remove(temporary, ec);
+        return written;
+    }
+
+    /**
+     * @brief Retrieve a uniform random sample of the objects of target file, for previewing huge files
+     * @param filename Target file
+     * @param preview Size of the sample, spatial coverage and random seed
+     * @param options Parse options; ParseOptions::recordTypes selects the sampled types
+     * @param report Receives the diagnostics of the records read; records counts the sampled objects
+     * @return At most preview.budget objects of the file, grouped by type
+     */
+    GeometrySet getPreview(const std::string& filename, const PreviewOptions& preview, const ParseOptions& options, ParseReport& report) {
+        GeometrySet geometry;
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            report.diagnostics.push_back({ 0, 0, "", "cannot open file '" + filename + "'" });
+            return geometry;
+        }
+        if (preview.budget == 0) return geometry;
+
+        std::mt19937_64 rng(preview.seed ? preview.seed : std::random_device()());
+        const std::size_t candidates = preview.spatialCoverage ? preview.budget * CoverageOversampling : preview.budget;
+
+        ParseReport scan_report;
+        std::vector<Record> sample;
+        if (!sampleByIndex(filename, in, candidates, rng, options, scan_report, sample)) {
+            scan_report = ParseReport();
+            in.clear();
+            in.seekg(0);
+            sample = sampleByScan(in, candidates, rng, options, scan_report);
+        }
+        if (preview.spatialCoverage) {
+            sample = coverGrid(sample, preview.budget, rng);
+        }
+
+        // Returned in file order
+        std::sort(sample.begin(), sample.end(), [](const Record& a, const Record& b) { return a.offset < b.offset; });
+        for (const Record& rec : sample) {
+            geometry.add(rec);
+        }
+        report.records += sample.size();
+        report.aborted = report.aborted || scan_report.aborted;
+        report.diagnostics.insert(report.diagnostics.end(), scan_report.diagnostics.begin(), scan_report.diagnostics.end());
+        return geometry;
+    }
+}
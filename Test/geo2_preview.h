@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    struct PreviewOptions {
+        // Max. # of objects returned
+        std::size_t budget = 10000;
+        // Spread the sample over the extent of the data instead of following its density
+        bool spatialCoverage = false;
+        // Seed of the random sample; 0 picks a different sample on every call
+        std::uint64_t seed = 0;
+    };
+
+    // Write the record index "<file>.geo2idx": the offset of every stride-th record, for strided preview loading
+    bool buildIndex(const std::string& filename, std::size_t stride = 64);
+    // Path of the record index of a file
+    std::string indexPath(const std::string& filename);
+
+    /**
+     * Import a uniform random sample of at most PreviewOptions::budget objects (of the types selected by
+     * ParseOptions::recordTypes). With an up-to-date record index the sample is read by seeking to
+     * budget spots of the file; otherwise the whole file is scanned with reservoir sampling,
+     * which parses the records but builds CGAL objects for the sample only.
+     */
+    GeometrySet getPreview(const std::string& filename, const PreviewOptions& preview, const ParseOptions& options, ParseReport& report);
+}
@@ -0,0 +1,174 @@
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <new>
+#include <vector>
+
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "geo2_stream.h"
+
+namespace Geo2Util {
+    /**
+     * Control block at the start of the shared memory; the ring data follows it.
+     * head and tail are running byte counts, their difference is the # of unread bytes.
+     */
+    struct SharedRing {
+        boost::interprocess::interprocess_mutex mutex;
+        boost::interprocess::interprocess_condition dataReady;
+        boost::interprocess::interprocess_condition spaceReady;
+        std::uint64_t capacity = 0;
+        std::uint64_t head = 0;
+        std::uint64_t tail = 0;
+        bool closed = false;
+
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    namespace {
+        typedef boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> RingLock;
+    }
+
+    /**
+     * @brief Create the shared-memory channel; an existing channel of the same name is replaced
+     * @param name Name of the channel, shared with the consumer
+     * @param capacity Size of the ring buffer in bytes
+     */
+    GeometryProducer::GeometryProducer(const std::string& name, std::size_t capacity) : name(name) {
+        using namespace boost::interprocess;
+        shared_memory_object::remove(name.c_str());
+        shm = shared_memory_object(create_only, name.c_str(), read_write);
+        shm.truncate((offset_t)(sizeof(SharedRing) + capacity));
+        region = mapped_region(shm, read_write);
+
+        ring = new (region.get_address()) SharedRing();
+        ring->capacity = capacity;
+    }
+
+    /**
+     * @brief Close the stream and remove the channel name; an attached consumer keeps its mapping
+     */
+    GeometryProducer::~GeometryProducer() {
+        close();
+        boost::interprocess::shared_memory_object::remove(name.c_str());
+    }
+
+    /**
+     * @brief Send the string representation of one 2D geometry object
+     * @param geo2_Object String representation of a 2D geometry object (see toString)
+     */
+    void GeometryProducer::send(const std::string& geo2_Object) {
+        write(geo2_Object.data(), geo2_Object.size());
+    }
+
+    /**
+     * @brief Send a collection of 2D geometry objects, like printToFile does for a file
+     * @param geo2_Objects String representations of a collection of 2D geometry objects
+     */
+    void GeometryProducer::send(const std::vector<std::string>& geo2_Objects) {
+        for (const std::string& obj : geo2_Objects) {
+            write(obj.data(), obj.size());
+        }
+    }
+
+    /**
+     * @brief Mark the end of the stream; the consumer finishes once it has received everything
+     */
+    void GeometryProducer::close() {
+        RingLock lock(ring->mutex);
+        ring->closed = true;
+        ring->dataReady.notify_all();
+    }
+
+    /**
+     * @brief Copy one record (plus its terminating newline) into the ring, waiting for free space when necessary
+     * @param data Record text
+     * @param len Length of the record text
+     */
+    void GeometryProducer::write(const char* data, std::size_t len) {
+        RingLock lock(ring->mutex);
+        const std::uint64_t capacity = ring->capacity;
+        auto append = [&](const char* bytes, std::size_t num_bytes) {
+            while (num_bytes > 0) {
+                while (ring->head - ring->tail == capacity) {
+                    ring->spaceReady.wait(lock);
+                }
+                const std::uint64_t pos = ring->head % capacity;
+                const std::size_t n = (std::size_t)std::min<std::uint64_t>(
+                    { (std::uint64_t)num_bytes, capacity - (ring->head - ring->tail), capacity - pos });
+                std::memcpy(ring->data() + pos, bytes, n);
+                ring->head += n;
+                bytes += n;
+                num_bytes -= n;
+                ring->dataReady.notify_all();
+            }
+        };
+        append(data, len);
+        append("\n", 1);
+    }
+
+    /**
+     * @brief Attach to a channel created by a GeometryProducer
+     * @param name Name of the channel
+     * @param options Parse options of the received records
+     */
+    GeometryConsumer::GeometryConsumer(const std::string& name, const ParseOptions& options) : options(options) {
+        using namespace boost::interprocess;
+        shm = shared_memory_object(open_only, name.c_str(), read_write);
+        region = mapped_region(shm, read_write);
+        ring = static_cast<SharedRing*>(region.get_address());
+    }
+
+    /**
+     * @brief Wait for data, then parse the complete records received so far
+     * @param timeout Maximum waiting time if no data is available
+     * @return The newly received objects, grouped by type (empty on timeout)
+     */
+    GeometrySet GeometryConsumer::receive(std::chrono::milliseconds timeout) {
+        GeometrySet objects;
+        if (done) return objects;
+
+        bool closed;
+        {
+            RingLock lock(ring->mutex);
+            const boost::posix_time::ptime deadline =
+                boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeout.count());
+            while (ring->head == ring->tail && !ring->closed) {
+                if (!ring->dataReady.timed_wait(lock, deadline)) break;
+            }
+
+            const std::uint64_t capacity = ring->capacity;
+            while (ring->head != ring->tail) {
+                const std::uint64_t pos = ring->tail % capacity;
+                const std::size_t n = (std::size_t)std::min(ring->head - ring->tail, capacity - pos);
+                pending.append(ring->data() + pos, n);
+                ring->tail += n;
+            }
+            closed = ring->closed;
+            ring->spaceReady.notify_all();
+        }
+
+        MemoryBuffer buffer(pending.data(), pending.data() + pending.size());
+        std::istream in(&buffer);
+        options.pendingTail = !closed;
+        RecordReader reader(in, options, parseReport, parsedOffset, parsedLines, parsedLayer);
+        Record rec;
+        while (reader.next(rec)) {
+            objects.add(rec);
+        }
+
+        pending.erase(0, (std::size_t)(reader.offset() - parsedOffset));
+        parsedOffset = reader.offset();
+        parsedLines = reader.line();
+        parsedLayer = reader.layer();
+        if (closed) {
+            pending.clear();
+            done = true;
+        }
+        return objects;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    // Ring buffer shared by a producer and a consumer; defined in geo2_stream.cpp
+    struct SharedRing;
+
+    /**
+     * Sends geometry records (the toString representations, same as printToFile) to a
+     * local consumer process through a shared-memory ring buffer, without touching disk.
+     */
+    class GeometryProducer {
+    public:
+        // Create (or re-create) the shared-memory channel called name, with a ring of capacity bytes
+        explicit GeometryProducer(const std::string& name, std::size_t capacity = 1 << 22);
+        ~GeometryProducer();
+
+        GeometryProducer(const GeometryProducer&) = delete;
+        GeometryProducer& operator=(const GeometryProducer&) = delete;
+
+        // Send one object / a collection of objects; blocks while the ring is full
+        void send(const std::string& geo2_Object);
+        void send(const std::vector<std::string>& geo2_Objects);
+        // Signal the end of the stream to the consumer
+        void close();
+
+    private:
+        void write(const char* data, std::size_t len);
+
+        std::string name;
+        boost::interprocess::shared_memory_object shm;
+        boost::interprocess::mapped_region region;
+        SharedRing* ring = nullptr;
+    };
+
+    /**
+     * Receiving end of a GeometryProducer channel; parses the records into CGAL objects.
+     * Records that are only partially transferred are kept until they are complete.
+     */
+    class GeometryConsumer {
+    public:
+        // Open the channel called name; throws boost::interprocess::interprocess_exception if it does not exist
+        explicit GeometryConsumer(const std::string& name, const ParseOptions& options = ParseOptions());
+
+        GeometryConsumer(const GeometryConsumer&) = delete;
+        GeometryConsumer& operator=(const GeometryConsumer&) = delete;
+
+        // Wait up to timeout for data, then return the complete objects received so far
+        GeometrySet receive(std::chrono::milliseconds timeout);
+        // True once the producer has closed the stream and everything has been received
+        bool finished() const { return done; }
+        // Diagnostics of all receives so far
+        const ParseReport& report() const { return parseReport; }
+
+    private:
+        boost::interprocess::shared_memory_object shm;
+        boost::interprocess::mapped_region region;
+        SharedRing* ring = nullptr;
+
+        ParseOptions options;
+        ParseReport parseReport;
+        std::string pending;
+        std::uint64_t parsedOffset = 0;
+        std::size_t parsedLines = 0;
+        std::string parsedLayer;
+        bool done = false;
+    };
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <unordered_map>
 
 #include <boost/algorithm/string/split.hpp> // boost::split
 #include <boost/algorithm/string/classification.hpp > // boost::is_any_of
@@ -181,6 +182,24 @@ namespace Geo2Util {
             + toString(ray.point(1));
     }
 
+    /**
+     * @brief Convert Mesh_2 object to string with its vertex table and the index lists of its faces, with default visual setting
+     * @param mesh Mesh_2 object
+     * @return A string object containing the representation of Mesh_2 object
+     */
+    std::string toString(const Mesh_2& mesh) {
+        return toString(mesh, Geo2Util::DefaultBoundaryColor, Geo2Util::DefaultBoundaryType, Geo2Util::DefaultInteriorColor);
+    }
+
+    /**
+     * @brief Convert Polyline_2 object to string with all its vertices, with default visual setting
+     * @param polyline Polyline_2 object
+     * @return A string object containing the representation of Polyline_2 object
+     */
+    std::string toString(const Polyline_2& polyline) {
+        return toString(polyline, Geo2Util::DefaultBoundaryColor, Geo2Util::DefaultBoundaryType);
+    }
+
     /**
      * @brief Convert Point_2 object to string with its x and y coordinate, with customized visual setting
      * @param p Point_2 object
@@ -349,6 +368,237 @@ namespace Geo2Util {
             + toString(ray.point(1), boundaryColor, btype, boundaryColor);
     }
 
+    /**
+     * @brief Convert Mesh_2 object to string with its vertex table and the index lists of its faces, with customized visual setting
+     * @param mesh Mesh_2 object
+     * @param boundaryColor Boundary color to be set (of every face)
+     * @param btype Boundary type to be set (of every face)
+     * @param interiorColor Interior color to be set (of every face)
+     * @return A string object containing the representation of Mesh_2 object
+     */
+    std::string toString(const Mesh_2& mesh, const Color& boundaryColor, const BoundaryType btype, const Color& interiorColor) {
+        std::ostringstream m;
+        m << std::fixed << std::setprecision(10) << "MESH "
+            << mesh.vertices.size() << " "
+            << mesh.faceSizes.size() << " "
+            << toString(boundaryColor) << " "
+            << toString(btype) << " "
+            << toString(interiorColor);
+
+        for (const Point_2& v : mesh.vertices) {
+            m << "\n" << v.x() << " " << v.y();
+        }
+        std::size_t index = 0;
+        for (std::size_t face_size : mesh.faceSizes) {
+            m << "\n" << face_size;
+            for (std::size_t i = 0; i < face_size; ++i, ++index) {
+                m << " " << mesh.indices[index];
+            }
+        }
+        return m.str();
+    }
+
+    /**
+     * @brief Convert Polyline_2 object to string with all its vertices, with customized visual setting
+     * @param polyline Polyline_2 object
+     * @param boundaryColor Boundary color to be set
+     * @param btype Boundary type to be set
+     * @return A string object containing the representation of Polyline_2 object
+     */
+    std::string toString(const Polyline_2& polyline, const Color& boundaryColor, const BoundaryType btype) {
+        std::string points_str = "";
+        for (auto it = polyline.vertices.begin(); it != polyline.vertices.end(); ++it) {
+            points_str += "\n" + toString(*it, boundaryColor, btype, boundaryColor);
+        }
+
+        return "POLYLINE " + std::to_string(polyline.vertices.size()) + " "
+            + toString(boundaryColor) + " "
+            + toString(btype)
+            + points_str;
+    }
+
+    namespace {
+        // Hash of exact vertex coordinates, for merging the shared vertices of faces
+        struct PointHash {
+            std::size_t operator()(const Point_2& p) const {
+                // + 0.0 maps -0.0 to 0.0, which compares equal
+                const std::size_t hx = std::hash<double>()(p.x() + 0.0);
+                const std::size_t hy = std::hash<double>()(p.y() + 0.0);
+                return hx ^ (hy + 0x9e3779b9 + (hx << 6) + (hx >> 2));
+            }
+        };
+
+        /**
+         * @brief Append a face to a mesh, reusing the vertices that the mesh already has
+         * @param mesh Target mesh
+         * @param index Vertex -> index map of the mesh
+         * @param first First vertex of the face
+         * @param last End of the vertices of the face
+         */
+        template <class VertexIterator>
+        void addFace(Mesh_2& mesh, std::unordered_map<Point_2, std::size_t, PointHash>& index, VertexIterator first, VertexIterator last) {
+            std::size_t face_size = 0;
+            for (auto it = first; it != last; ++it, ++face_size) {
+                auto inserted = index.emplace(*it, mesh.vertices.size());
+                if (inserted.second) mesh.vertices.push_back(*it);
+                mesh.indices.push_back(inserted.first->second);
+            }
+            mesh.faceSizes.push_back(face_size);
+        }
+    }
+
+    /**
+     * @brief Merge a collection of triangles into a shared-vertex mesh; identical vertices are stored once
+     * @param tris Triangle_2 objects
+     * @return Mesh_2 object with one face per triangle
+     */
+    Mesh_2 toMesh(const std::vector<Triangle_2>& tris) {
+        Mesh_2 mesh;
+        std::unordered_map<Point_2, std::size_t, PointHash> index;
+        mesh.indices.reserve(3 * tris.size());
+        mesh.faceSizes.reserve(tris.size());
+        for (const Triangle_2& tri : tris) {
+            const Point_2 vertices[3] = { tri[0], tri[1], tri[2] };
+            addFace(mesh, index, vertices, vertices + 3);
+        }
+        return mesh;
+    }
+
+    /**
+     * @brief Merge a collection of polygons into a shared-vertex mesh; identical vertices are stored once
+     * @param polys Polygon_2 objects
+     * @return Mesh_2 object with one face per polygon
+     */
+    Mesh_2 toMesh(const std::vector<Polygon_2>& polys) {
+        Mesh_2 mesh;
+        std::unordered_map<Point_2, std::size_t, PointHash> index;
+        mesh.faceSizes.reserve(polys.size());
+        for (const Polygon_2& poly : polys) {
+            addFace(mesh, index, poly.begin(), poly.end());
+        }
+        return mesh;
+    }
+
+    /**
+     * @brief Rebuild the triangles of a mesh; faces that are not triangles are ignored
+     * @param mesh Mesh_2 object
+     * @return A vector of Triangle_2 objects
+     */
+    std::vector<Triangle_2> toTriangles(const Mesh_2& mesh) {
+        std::vector<Triangle_2> tris;
+        tris.reserve(mesh.faceSizes.size());
+        std::size_t index = 0;
+        for (std::size_t face_size : mesh.faceSizes) {
+            if (face_size == 3) {
+                tris.push_back(
+                    Triangle_2(
+                        mesh.vertices[mesh.indices[index]],
+                        mesh.vertices[mesh.indices[index + 1]],
+                        mesh.vertices[mesh.indices[index + 2]]
+                    )
+                );
+            }
+            index += face_size;
+        }
+        return tris;
+    }
+
+    /**
+     * @brief Rebuild the faces of a mesh as polygons
+     * @param mesh Mesh_2 object
+     * @return A vector of Polygon_2 objects
+     */
+    std::vector<Polygon_2> toPolygons(const Mesh_2& mesh) {
+        std::vector<Polygon_2> polys;
+        polys.reserve(mesh.faceSizes.size());
+        std::size_t index = 0;
+        for (std::size_t face_size : mesh.faceSizes) {
+            Polygon_2 poly;
+            for (std::size_t i = 0; i < face_size; ++i, ++index) {
+                poly.push_back(mesh.vertices[mesh.indices[index]]);
+            }
+            polys.push_back(poly);
+        }
+        return polys;
+    }
+
+    /**
+     * @brief Chain segments that share endpoints (exactly equal coordinates) into polylines.
+     * Every segment ends up in exactly one polyline, reversed where needed; at a vertex shared by more
+     * than two segments the chain continues with one of them, the others start chains of their own.
+     * @param segs Segment_2 objects
+     * @return Polyline_2 objects, each with at least 2 vertices
+     */
+    std::vector<Polyline_2> toPolylines(const std::vector<Segment_2>& segs) {
+        std::vector<std::size_t> first_segments;
+        return toPolylines(segs, first_segments);
+    }
+
+    /**
+     * @brief Chain segments into polylines like toPolylines(segs), and tell which segment each polyline was started from
+     * @param segs Segment_2 objects
+     * @param firstSegments Receives the index of the lowest-indexed segment of each polyline; a polyline with
+     * 2 vertices is that segment, with the same orientation
+     * @return Polyline_2 objects, each with at least 2 vertices
+     */
+    std::vector<Polyline_2> toPolylines(const std::vector<Segment_2>& segs, std::vector<std::size_t>& firstSegments) {
+        firstSegments.clear();
+        std::unordered_multimap<Point_2, std::size_t, PointHash> ends;
+        ends.reserve(2 * segs.size());
+        for (std::size_t i = 0; i < segs.size(); ++i) {
+            ends.emplace(segs[i].source(), i);
+            ends.emplace(segs[i].target(), i);
+        }
+
+        std::vector<bool> used(segs.size(), false);
+        // Extend a chain at its last vertex with unused segments, appending their other endpoints
+        auto extend = [&](std::vector<Point_2>& chain) {
+            bool extended = true;
+            while (extended) {
+                extended = false;
+                auto range = ends.equal_range(chain.back());
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (used[it->second]) continue;
+                    const Segment_2& seg = segs[it->second];
+                    used[it->second] = true;
+                    chain.push_back(seg.source() == chain.back() ? seg.target() : seg.source());
+                    extended = true;
+                    break;
+                }
+            }
+        };
+
+        std::vector<Polyline_2> polylines;
+        for (std::size_t i = 0; i < segs.size(); ++i) {
+            if (used[i]) continue;
+            used[i] = true;
+            std::vector<Point_2> forward = { segs[i].source(), segs[i].target() };
+            extend(forward);
+            std::vector<Point_2> backward = { segs[i].source() };
+            extend(backward);
+
+            Polyline_2 polyline;
+            polyline.vertices.assign(backward.rbegin(), backward.rend() - 1);
+            polyline.vertices.insert(polyline.vertices.end(), forward.begin(), forward.end());
+            polylines.push_back(polyline);
+            firstSegments.push_back(i);
+        }
+        return polylines;
+    }
+
+    /**
+     * @brief Split a polyline into its segments
+     * @param polyline Polyline_2 object
+     * @return A vector of Segment_2 objects, one per pair of consecutive vertices
+     */
+    std::vector<Segment_2> toSegments(const Polyline_2& polyline) {
+        std::vector<Segment_2> segs;
+        for (std::size_t i = 1; i < polyline.vertices.size(); ++i) {
+            segs.push_back(Segment_2(polyline.vertices[i - 1], polyline.vertices[i]));
+        }
+        return segs;
+    }
+
     /**
      * @brief Export a collect of 2D geometry objects to a file
      * @param filename Export target file
@@ -409,11 +659,29 @@ namespace Geo2Util {
             else if (header[0] == "RAY") {
                 num_lines = RayDetailLength;
             }
-            else if (header[0] == "POLYGON") {
+            else if (header[0] == "POLYGON" || header[0] == "POLYLINE") {
                 if (header.size() < 2) // invalid data format
                     return; 
                 num_lines = std::stoi(header[1]);
             }
+            else if (header[0] == "MESH") {
+                if (header.size() < 3) // invalid data format
+                    return;
+                num_lines = std::stoi(header[1]) + std::stoi(header[2]);
+            }
+            else if (header[0] == "POLYGON_WITH_HOLES") {
+                if (header.size() < 2) // invalid data format
+                    return;
+                // outer boundary + holes, each a nested POLYGON object
+                const int num_polygons = std::stoi(header[1]) + 1;
+                std::string content;
+                for (int i = 0; i < num_polygons && std::getline(in, content); ++i) {
+                    std::vector<std::string> nested;
+                    boost::split(nested, content, boost::is_any_of(" \n"));
+                    skipObjectDetails(in, nested);
+                }
+                return;
+            }
             else {
                 num_lines = 0;
             }
@@ -423,6 +691,75 @@ namespace Geo2Util {
                 in.ignore(max_len_per_line, '\n');
             }
         }
+
+        /**
+         * @brief This "private" function reads the vertices of a POLYGON object from the input stream.
+         * @param in Input stream, positioned after the header
+         * @param header Object header
+         * @return Polygon_2 object
+         */
+        Polygon_2 readPolygonDetails(std::ifstream& in, std::vector<std::string>& header) {
+            int numVertices = std::stoi(header[1]);
+
+            Polygon_2 poly;
+            std::string content;
+            std::vector<std::string> detail;
+
+            for (int i = 0; i < numVertices; ++i) {
+                std::getline(in, content);
+                boost::split(detail, content, boost::is_any_of(" \n"));
+                double x = std::stod(detail[1]);
+                double y = std::stod(detail[2]);
+
+                poly.push_back(Point_2(x, y));
+            }
+            return poly;
+        }
+
+        /**
+         * @brief This "private" function reads the vertices of a POLYLINE object from the input stream.
+         * @param in Input stream, positioned after the header
+         * @param header Object header
+         * @return Polyline_2 object
+         */
+        Polyline_2 readPolylineDetails(std::ifstream& in, std::vector<std::string>& header) {
+            const Polygon_2 vertices = readPolygonDetails(in, header); // same POINT detail lines
+            Polyline_2 polyline;
+            polyline.vertices.assign(vertices.begin(), vertices.end());
+            return polyline;
+        }
+
+        /**
+         * @brief This "private" function reads the vertex table and the faces of a MESH object from the input stream.
+         * @param in Input stream, positioned after the header
+         * @param header Object header
+         * @return Mesh_2 object
+         */
+        Mesh_2 readMeshDetails(std::ifstream& in, std::vector<std::string>& header) {
+            Mesh_2 mesh;
+            const std::size_t num_vertices = std::stoul(header[1]);
+            const std::size_t num_faces = std::stoul(header[2]);
+
+            std::string content;
+            std::vector<std::string> detail;
+            mesh.vertices.reserve(num_vertices);
+            for (std::size_t i = 0; i < num_vertices; ++i) {
+                std::getline(in, content);
+                boost::split(detail, content, boost::is_any_of(" \n"));
+                mesh.vertices.push_back(Point_2(std::stod(detail[0]), std::stod(detail[1])));
+            }
+            mesh.faceSizes.reserve(num_faces);
+            for (std::size_t i = 0; i < num_faces; ++i) {
+                std::getline(in, content);
+                boost::split(detail, content, boost::is_any_of(" \n"));
+                const std::size_t face_size = std::stoul(detail[0]);
+                for (std::size_t j = 1; j <= face_size; ++j) {
+                    mesh.indices.push_back(std::stoul(detail[j]));
+                }
+                mesh.faceSizes.push_back(face_size);
+            }
+            return mesh;
+        }
     }
 
     /**
@@ -590,6 +927,10 @@ namespace Geo2Util {
                     )
                 );
             } 
+            else if (header[0] == "MESH") {
+                std::vector<Triangle_2> mesh_tris = toTriangles(readMeshDetails(in, header));
+                tris.insert(tris.end(), mesh_tris.begin(), mesh_tris.end());
+            }
             else {
                 skipObjectDetails(in, header);
             }
@@ -629,6 +970,10 @@ namespace Geo2Util {
                     )
                 );
             } 
+            else if (header[0] == "POLYLINE") {
+                std::vector<Segment_2> polyline_segs = toSegments(readPolylineDetails(in, header));
+                segs.insert(segs.end(), polyline_segs.begin(), polyline_segs.end());
+            }
             else {
                 skipObjectDetails(in, header);
             }
@@ -689,21 +1034,43 @@ namespace Geo2Util {
             std::vector<std::string> header;
             boost::split(header, content, boost::is_any_of(" \n"));
             if (header[0] == "POLYGON") {
-                int numVertices = std::stoi(header[1]);
+                polygons.push_back(readPolygonDetails(in, header));
+            } 
+            else {
+                skipObjectDetails(in, header);
+            }
+        }
+        in.close();
+        return polygons;
+    }
 
-                Polygon_2 poly;
-                std::vector<std::string> detail;
+    /**
+     * @brief Retrieve a vector of Polygon_with_holes_2 objects from target file.
+     * @param filename Target file
+     * @return A vector of Polygon_with_holes_2 objects
+     */
+    std::vector<Polygon_with_holes_2> getPolygonsWithHoles(const std::string& filename) {
+        std::ifstream in(filename);
+        std::vector<Polygon_with_holes_2> polygons;
+        std::string content;
+        while (std::getline(in, content)) {
+            std::vector<std::string> header;
+            boost::split(header, content, boost::is_any_of(" \n"));
+            if (header[0] == "POLYGON_WITH_HOLES") {
+                int numHoles = std::stoi(header[1]);
 
-                for (int i = 0; i < numVertices; ++i) {
-                    std::getline(in, content);
-                    boost::split(detail, content, boost::is_any_of(" \n"));
-                    double x = std::stod(detail[1]);
-                    double y = std::stod(detail[2]);
+                std::vector<std::string> nested;
+                std::getline(in, content);
+                boost::split(nested, content, boost::is_any_of(" \n"));
+                Polygon_with_holes_2 poly_w_h(readPolygonDetails(in, nested));
 
-                    poly.push_back(Point_2(x, y));
+                for (int i = 0; i < numHoles; ++i) {
+                    std::getline(in, content);
+                    boost::split(nested, content, boost::is_any_of(" \n"));
+                    poly_w_h.add_hole(readPolygonDetails(in, nested));
                 }
-                polygons.push_back(poly);
-            } 
+                polygons.push_back(poly_w_h);
+            }
             else {
                 skipObjectDetails(in, header);
             }
@@ -711,4 +1078,49 @@ namespace Geo2Util {
         in.close();
         return polygons;
     }
+
+    /**
+     * @brief Retrieve a vector of Mesh_2 objects from target file.
+     * @param filename Target file
+     * @return A vector of Mesh_2 objects
+     */
+    std::vector<Mesh_2> getMeshes(const std::string& filename) {
+        std::ifstream in(filename);
+        std::vector<Mesh_2> meshes;
+        std::string content;
+        while (std::getline(in, content)) {
+            std::vector<std::string> header;
+            boost::split(header, content, boost::is_any_of(" \n"));
+            if (header[0] == "MESH") {
+                meshes.push_back(readMeshDetails(in, header));
+            }
+            else {
+                skipObjectDetails(in, header);
+            }
+        }
+        in.close();
+        return meshes;
+    }
+    /**
+     * @brief Retrieve a vector of Polyline_2 objects from target file.
+     * @param filename Target file
+     * @return A vector of Polyline_2 objects
+     */
+    std::vector<Polyline_2> getPolylines(const std::string& filename) {
+        std::ifstream in(filename);
+        std::vector<Polyline_2> polylines;
+        std::string content;
+        while (std::getline(in, content)) {
+            std::vector<std::string> header;
+            boost::split(header, content, boost::is_any_of(" \n"));
+            if (header[0] == "POLYLINE") {
+                polylines.push_back(readPolylineDetails(in, header));
+            }
+            else {
+                skipObjectDetails(in, header);
+            }
+        }
+        in.close();
+        return polylines;
+    }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <string>
 #include <vector>
 
@@ -18,6 +19,18 @@ namespace Geo2Util {
     typedef CGAL::Polygon_2<K> Polygon_2;
     typedef CGAL::Polygon_with_holes_2<K> Polygon_with_holes_2;
 
+    // Mesh of faces (triangles or polygons) sharing their vertices
+    struct Mesh_2 {
+        std::vector<Point_2> vertices;
+        std::vector<std::size_t> indices;   // vertex indices of all faces, face after face
+        std::vector<std::size_t> faceSizes; // # of vertices of each face
+    };
+
+    // Chain of segments connected end to end (closed if the first and the last vertex are equal)
+    struct Polyline_2 {
+        std::vector<Point_2> vertices;
+    };
+
     struct Color {
         short r;
         short g;
@@ -51,6 +64,8 @@ namespace Geo2Util {
     std::string toString(const Polygon_with_holes_2 & poly_w_h);
     std::string toString(const Line_2& line);
     std::string toString(const Ray_2& ray);
+    std::string toString(const Mesh_2& mesh);
+    std::string toString(const Polyline_2& polyline);
 
     // Customized toString
     //! Underlying points of all objects (except Point_2) have the same color (boundary color and interior color) as its boundary color
@@ -64,6 +79,22 @@ namespace Geo2Util {
     std::string toString(const Polygon_with_holes_2& poly_w_h, const Color& boundaryColor, const BoundaryType btype, const Color& interiorColor);
     std::string toString(const Line_2& line, const Color& boundaryColor, const BoundaryType btype);
     std::string toString(const Ray_2& ray, const Color& boundaryColor, const BoundaryType btype);
+    std::string toString(const Mesh_2& mesh, const Color& boundaryColor, const BoundaryType btype, const Color& interiorColor);
+    std::string toString(const Polyline_2& polyline, const Color& boundaryColor, const BoundaryType btype);
+
+    // Shared-vertex meshes; a triangulation export as one MESH record writes each vertex once
+    Mesh_2 toMesh(const std::vector<Triangle_2>& tris);
+    Mesh_2 toMesh(const std::vector<Polygon_2>& polys);
+    template <class Triangulation>
+    Mesh_2 toMesh(const Triangulation& tr); // finite faces of a CGAL 2D triangulation
+    std::vector<Triangle_2> toTriangles(const Mesh_2& mesh); // faces with 3 vertices
+    std::vector<Polygon_2> toPolygons(const Mesh_2& mesh);
+
+    // Polylines; chaining segments that share endpoints writes each shared endpoint once
+    std::vector<Polyline_2> toPolylines(const std::vector<Segment_2>& segs);
+    // firstSegments: index of the lowest-indexed segment of each polyline (the polyline itself if it has 2 vertices)
+    std::vector<Polyline_2> toPolylines(const std::vector<Segment_2>& segs, std::vector<std::size_t>& firstSegments);
+    std::vector<Segment_2> toSegments(const Polyline_2& polyline);
     
     // Export CGAL 2D Geometry Object to File
     void printToFile(const std::string& filename, const std::vector<std::string>& geo2_Objects);
@@ -78,4 +109,29 @@ namespace Geo2Util {
     std::vector<Segment_2> getSegments(const std::string& filename);
     std::vector<Ray_2> getRays(const std::string& filename); 
     std::vector<Polygon_2> getPolygons(const std::string& filename); 
+    std::vector<Polygon_with_holes_2> getPolygonsWithHoles(const std::string& filename);
+    std::vector<Mesh_2> getMeshes(const std::string& filename);
+    std::vector<Polyline_2> getPolylines(const std::string& filename);
+
+    /**
+     * @brief Convert the finite faces of a CGAL 2D triangulation (Delaunay, constrained, ...) to a shared-vertex mesh
+     * @param tr Triangulation
+     * @return Mesh with one vertex per finite triangulation vertex and one face per finite face
+     */
+    template <class Triangulation>
+    Mesh_2 toMesh(const Triangulation& tr) {
+        Mesh_2 mesh;
+        std::map<typename Triangulation::Vertex_handle, std::size_t> index;
+        for (auto v = tr.finite_vertices_begin(); v != tr.finite_vertices_end(); ++v) {
+            index[v] = mesh.vertices.size();
+            mesh.vertices.push_back(v->point());
+        }
+        for (auto f = tr.finite_faces_begin(); f != tr.finite_faces_end(); ++f) {
+            for (int i = 0; i < 3; ++i) {
+                mesh.indices.push_back(index[f->vertex(i)]);
+            }
+            mesh.faceSizes.push_back(3);
+        }
+        return mesh;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "geo2_watch.h"
+
+namespace Geo2Util {
+    namespace {
+        // # of bytes in front of offset() that are compared on every poll(), to notice a file rewritten in place
+        const std::size_t TailCheckBytes = 64;
+
+        // Current size, modification time and inode of a file; all zero if it does not exist (yet)
+        FileWatcher::FileState fileState(const std::string& filename) {
+            FileWatcher::FileState state;
+            std::error_code ec;
+            const std::uintmax_t size = std::filesystem::file_size(filename, ec);
+            if (ec) return state;
+            state.size = (std::uint64_t)size;
+            state.modified = std::filesystem::last_write_time(filename, ec);
+#ifdef __linux__
+            struct stat st;
+            if (::stat(filename.c_str(), &st) == 0) state.inode = (std::uint64_t)st.st_ino;
+#endif
+            return state;
+        }
+
+        bool operator==(const FileWatcher::FileState& a, const FileWatcher::FileState& b) {
+            return a.size == b.size && a.modified == b.modified && a.inode == b.inode;
+        }
+    }
+
+    /**
+     * @brief Start watching a file; nothing is imported until the first poll()
+     * @param filename Watched file
+     * @param options Parse options; ParseOptions::pendingTail is always enabled
+     */
+    FileWatcher::FileWatcher(const std::string& filename, const ParseOptions& options)
+        : filename(filename), options(options) {
+        this->options.pendingTail = true;
+#ifdef __linux__
+        notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notifyFd >= 0 && inotify_add_watch(notifyFd, filename.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+            // e.g. the file does not exist yet; fall back to polling
+            close(notifyFd);
+            notifyFd = -1;
+        }
+#endif
+    }
+
+    FileWatcher::~FileWatcher() {
+#ifdef __linux__
+        if (notifyFd >= 0) close(notifyFd);
+#endif
+    }
+
+    /**
+     * @brief Import the complete records that have been appended since the last call
+     * @return The newly appended objects, grouped by type
+     */
+    GeometrySet FileWatcher::poll() {
+        GeometrySet increment;
+        restarted = false;
+
+        const FileState state = fileState(filename);
+        // A file that is shorter, has another inode, or has changed without growing has been truncated or replaced
+        if (parsedOffset > 0 && (state.size < parsedOffset || state.inode != seen.inode
+            || (state.size == seen.size && !(state.modified == seen.modified)))) {
+            restart();
+        }
+        seen = state;
+        if (state.size == parsedOffset) return increment;
+
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) return increment;
+        if (parsedOffset > 0) {
+            // A file rewritten in place to a larger size is caught by the bytes in front of offset()
+            std::string tail(parsedTail.size(), '\0');
+            in.seekg((std::streamoff)(parsedOffset - parsedTail.size()));
+            if (!in.read(&tail[0], (std::streamsize)tail.size()) || tail != parsedTail) {
+                restart();
+                in.clear();
+            }
+        }
+        in.seekg((std::streamoff)parsedOffset);
+
+        RecordReader reader(in, options, parseReport, parsedOffset, parsedLines, parsedLayer);
+        Record rec;
+        while (reader.next(rec)) {
+            increment.add(rec);
+        }
+        parsedOffset = reader.offset();
+        parsedLines = reader.line();
+        parsedLayer = reader.layer();
+
+        parsedTail.assign((std::size_t)std::min<std::uint64_t>(parsedOffset, TailCheckBytes), '\0');
+        in.clear();
+        in.seekg((std::streamoff)(parsedOffset - parsedTail.size()));
+        in.read(&parsedTail[0], (std::streamsize)parsedTail.size());
+        return increment;
+    }
+
+    /**
+     * @brief Forget what has been imported, so that the file is read again from byte 0
+     */
+    void FileWatcher::restart() {
+        parsedOffset = 0;
+        parsedLines = 0;
+        parsedLayer.clear();
+        parsedTail.clear();
+        restarted = true;
+    }
+
+    /**
+     * @brief Block until the watched file changes or timeout elapses, then import the appended records
+     * @param timeout Maximum waiting time
+     * @return The newly appended objects, grouped by type (empty on timeout)
+     */
+    GeometrySet FileWatcher::wait(std::chrono::milliseconds timeout) {
+        if (fileState(filename) == seen) {
+            waitForChange(timeout);
+        }
+        return poll();
+    }
+
+    /**
+     * @brief Wait for a change notification (inotify) or for the file to change since the last poll() (polling fallback)
+     * @param timeout Maximum waiting time
+     * @return true if a change has been detected
+     */
+    bool FileWatcher::waitForChange(std::chrono::milliseconds timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+#ifdef __linux__
+        if (notifyFd >= 0) {
+            // Events may be left over from writes that an earlier poll() has already seen, so re-check the size
+            while (fileState(filename) == seen) {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                pollfd pfd = { notifyFd, POLLIN, 0 };
+                if (remaining.count() <= 0 || ::poll(&pfd, 1, (int)remaining.count()) <= 0) return false;
+
+                alignas(inotify_event) char events[4096];
+                while (read(notifyFd, events, sizeof(events)) > 0) {}
+            }
+            return true;
+        }
+#endif
+        while (fileState(filename) == seen) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(pollInterval);
+        }
+        return true;
+    }
+}
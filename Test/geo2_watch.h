@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "geo2_parse.h"
+
+namespace Geo2Util {
+    /**
+     * Incremental importer of a file that is still being appended to.
+     * Every call parses only the bytes appended since the last complete record,
+     * so the cost of a refresh grows with the new data and not with the file size.
+     * File changes are detected with inotify on Linux, and by polling the file size and modification time elsewhere.
+     */
+    class FileWatcher {
+    public:
+        // What poll() remembers of the file, to notice that it has been truncated or replaced
+        struct FileState {
+            std::uint64_t size = 0;
+            std::filesystem::file_time_type modified;
+            std::uint64_t inode = 0;    // 0 where unavailable
+        };
+
+        explicit FileWatcher(const std::string& filename, const ParseOptions& options = ParseOptions());
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // Import the complete records appended since the last call; a partially written trailing record is left for later
+        GeometrySet poll();
+        // Block until the file changes (or timeout elapses), then poll()
+        GeometrySet wait(std::chrono::milliseconds timeout);
+
+        // Byte offset just past the last complete record imported
+        std::uint64_t offset() const { return parsedOffset; }
+        // True if the last poll() found the file truncated or replaced (shorter than offset(), another inode,
+        // changed without growing, or other bytes in front of offset()) and restarted from byte 0
+        bool rewound() const { return restarted; }
+        // Diagnostics of all polls so far
+        const ParseReport& report() const { return parseReport; }
+
+        // Interval of the size polling fallback
+        std::chrono::milliseconds pollInterval = std::chrono::milliseconds(50);
+
+    private:
+        bool waitForChange(std::chrono::milliseconds timeout);
+        void restart();
+
+        std::string filename;
+        ParseOptions options;
+        ParseReport parseReport;
+        std::uint64_t parsedOffset = 0;
+        std::size_t parsedLines = 0;
+        std::string parsedLayer;
+        std::string parsedTail;         // last bytes in front of parsedOffset
+        FileState seen;                 // state of the file at the last poll()
+        bool restarted = false;
+        int notifyFd = -1;
+    };
+}
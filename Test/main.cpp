@@ -6,8 +6,22 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <thread>
+#include <filesystem>
+#include <iterator>
 
 #include "geo2_util.h"
+#include "geo2_parse.h"
+#include "geo2_intersect.h"
+#include "geo2_watch.h"
+#include "geo2_stream.h"
+#include "geo2_cache.h"
+#include "geo2_export.h"
 
 using namespace std;
 typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
@@ -188,4 +202,261 @@ int main()
         std::vector<Polygon_2> polygons = Geo2Util::getPolygons("test_import.txt");
         printObjects(polygons);
     }
+
+    {   // non-throwing import test
+        Geo2Util::ParseOptions options;
+        options.errorBudget = 10;
+        Geo2Util::ParseReport report;
+
+        std::vector<Polygon_2> polygons = Geo2Util::getPolygons("test_import.txt", options, report);
+        std::cout << polygons.size() << " polygons, " << report.records << " records" << '\n';
+        for (auto& diag : report.diagnostics) {
+            std::cout << "line " << diag.line << " (byte " << diag.offset << ") "
+                << diag.recordType << ": " << diag.reason << '\n';
+        }
+    }
+
+    {   // resynchronization test: the records after a broken polygon are still imported
+        std::ofstream out("test_resync.txt");
+        out << "POLYGON bad 0 0 0 255 0 0 0 0 255\n"
+            << "POINT 0 0 0 0 0 255 0 0 0 0 255\n"
+            << "POLYGON 3 0 0 0 255 0 0 0 0 255\n"
+            << "POINT 0 0 0 0 0 255 0 0 0 0 255\nPOINT 1 0 0 0 0 255 0 0 0 0 255\nPOINT 0 1 0 0 0 255 0 0 0 0 255\n"
+            << "POLYGON 3 0 0 0 255 0 0 0 0 255\n"
+            << "POINT 2 2 0 0 0 255 0 0 0 0 255\nPOINT 3 2 0 0 0 255 0 0 0 0 255\nPOINT 2 3 0 0 0 255 0 0 0 0 255\n"
+            << "CIRCLE 1 0 0 0 255 0 0 0 0 255\nPOINT 5 5 0 0 0 255 0 0 0 0 255\n";
+        out.close();
+
+        Geo2Util::ParseOptions options;
+        Geo2Util::ParseReport report;
+        Geo2Util::GeometrySet geometry = Geo2Util::getGeometry("test_resync.txt", options, report);
+        std::cout << "resync: " << geometry.polygons.size() << " polygons (expected 2), " << geometry.circles.size()
+            << " circles (expected 1), " << geometry.points.size() << " points (expected 0), "
+            << report.diagnostics.size() << " diagnostics (expected 1)" << '\n';
+    }
+
+    {   // length test: a corrupt "@bytes/lines" token of a skipped record does not swallow the records after it
+        const std::string point = " 0 0 0 255 0 0 0 0 255\n";
+        std::ofstream out("test_length.txt");
+        out << "POINT 1 1" << point
+            << "LINE_SEGMENT 0 0 0 255 0 @999999/2\n" << "POINT 0 0" << point << "POINT 1 1" << point
+            << "LINE_SEGMENT 0 0 0 255 0 @5/2\n" << "POINT 0 0" << point << "POINT 1 1" << point
+            << "LINE_SEGMENT 0 0 0 255 0 @64/3\n" << "POINT 0 0" << point << "POINT 1 1" << point
+            << "POINT 2 2" << point << "POINT 3 3" << point << "POINT 4 4" << point;
+        out.close();
+
+        Geo2Util::ParseOptions options;
+        Geo2Util::ParseReport report;
+        std::vector<Point_2> points = Geo2Util::getPoints("test_length.txt", options, report);
+        std::cout << "length: " << points.size() << " points (expected 4), "
+            << report.diagnostics.size() << " diagnostics (expected 3)" << '\n';
+    }
+
+    {   // polling test: a malformed record still being written is reported once it is complete, and only once
+        const std::string point = " 0 0 0 255 0 0 0 0 255\n";
+        std::ofstream out("test_watch.txt");
+        out << "POINT 1 1" << point << "POLYGON 3 0 0 0 255 0 0 0 0 255\n" << "POINT 0 0" << point << "POINT x 1" << point << "POINT 1";
+        out.close();
+
+        Geo2Util::ParseOptions options;
+        options.errorBudget = 1;
+        Geo2Util::FileWatcher watcher("test_watch.txt", options);
+        std::size_t num_points = 0;
+        for (int i = 0; i < 4; ++i) num_points += watcher.poll().points.size();
+        std::cout << "polling: " << num_points << " points (expected 1), "
+            << watcher.report().diagnostics.size() << " diagnostics (expected 0)" << '\n';
+
+        out.open("test_watch.txt", std::ios::app);
+        out << " 1" << point << "POINT 2 2" << point;
+        out.close();
+        num_points += watcher.poll().points.size();
+        num_points += watcher.poll().points.size();
+        std::cout << "polling: " << num_points << " points (expected 2), "
+            << watcher.report().diagnostics.size() << " diagnostics (expected 1), "
+            << (watcher.report().aborted ? "aborted" : "not aborted") << " (expected not aborted)" << '\n';
+
+        // Rewritten in place, larger than before
+        out.open("test_watch.txt", std::ios::trunc);
+        for (int i = 0; i < 10; ++i) out << "POINT " << i + 10 << " 5" << point;
+        out.close();
+        num_points = watcher.poll().points.size();
+        std::cout << "polling: " << (watcher.rewound() ? "rewound" : "not rewound") << " (expected rewound), "
+            << num_points << " points (expected 10)" << '\n';
+    }
+
+    {   // streaming test: a file sent line by line through a small ring (so that it fills up and records wrap
+        // around its end) is received as the same objects as getGeometry reads from the file
+        Geo2Util::ParseOptions options;
+        Geo2Util::ParseReport file_report;
+        Geo2Util::GeometrySet expected = Geo2Util::getGeometry("test_import.txt", options, file_report);
+
+        Geo2Util::GeometryProducer producer("geo2_stream_test", 100);
+        Geo2Util::GeometryConsumer consumer("geo2_stream_test", options);
+        std::thread sender([&producer]() {
+            std::ifstream in("test_import.txt");
+            std::string line;
+            while (std::getline(in, line)) producer.send(line);
+            producer.close();
+        });
+        auto append = [](auto& to, const auto& from) { to.insert(to.end(), from.begin(), from.end()); };
+        Geo2Util::GeometrySet received;
+        std::size_t num_receives = 0;
+        while (!consumer.finished()) {
+            Geo2Util::GeometrySet part = consumer.receive(std::chrono::milliseconds(100));
+            append(received.points, part.points);
+            append(received.segments, part.segments);
+            append(received.polygons, part.polygons);
+            append(received.polygonsWithHoles, part.polygonsWithHoles);
+            append(received.meshes, part.meshes);
+            append(received.polylines, part.polylines);
+            append(received.circles, part.circles);
+            append(received.triangles, part.triangles);
+            append(received.rectangles, part.rectangles);
+            append(received.lines, part.lines);
+            append(received.rays, part.rays);
+            ++num_receives;
+        }
+        sender.join();
+        const bool same = received.size() == expected.size() && received.points == expected.points
+            && received.segments == expected.segments && received.polygons.size() == expected.polygons.size()
+            && received.polygonsWithHoles.size() == expected.polygonsWithHoles.size();
+        std::cout << "streaming: " << received.size() << " objects (expected " << expected.size() << ") in "
+            << num_receives << " receives, " << (same ? "same objects" : "different objects") << " (expected same objects), "
+            << consumer.report().diagnostics.size() << " diagnostics (expected " << file_report.diagnostics.size() << ")" << '\n';
+    }
+
+    {   // cache test: a snapshot is not used once its file has changed or it is damaged, and the least recently
+        // used snapshots are evicted first
+        namespace fs = std::filesystem;
+        const std::string point = " 0 0 0 255 0 0 0 0 255\n";
+        auto writeFile = [&point](const std::string& filename, int first) {
+            std::ofstream out(filename, std::ios::trunc);
+            for (int i = 0; i < 100; ++i) out << "POINT " << first + i << " 1" << point;
+        };
+        fs::remove_all("test_cache");
+        Geo2Util::CacheOptions cache_options;
+        cache_options.directory = "test_cache";
+        Geo2Util::GeometryCache cache(cache_options);
+        Geo2Util::ParseOptions options;
+        Geo2Util::ParseReport report;
+
+        writeFile("test_cache_a.txt", 100);
+        cache.load("test_cache_a.txt", options, report);
+        const double x = cache.load("test_cache_a.txt", options, report).points[0].x();
+        std::cout << "cache: " << (cache.hit() ? "hit" : "miss") << " (expected hit), first x " << x << " (expected 100)" << '\n';
+
+        // Same size and modification time, other content
+        const fs::file_time_type modified = fs::last_write_time("test_cache_a.txt");
+        writeFile("test_cache_a.txt", 200);
+        fs::last_write_time("test_cache_a.txt", modified);
+        const double changed_x = cache.load("test_cache_a.txt", options, report).points[0].x();
+        std::cout << "cache: " << (cache.hit() ? "hit" : "miss") << " after a change (expected miss), first x "
+            << changed_x << " (expected 200)" << '\n';
+
+        const std::string snapshot = cache.snapshotPath("test_cache_a.txt");
+        fs::resize_file(snapshot, fs::file_size(snapshot) / 2);
+        const std::size_t num_truncated = cache.load("test_cache_a.txt", options, report).points.size();
+        std::cout << "cache: " << (cache.hit() ? "hit" : "miss") << " on a truncated snapshot (expected miss), "
+            << num_truncated << " points (expected 100)" << '\n';
+        {
+            std::fstream damaged(snapshot, std::ios::in | std::ios::out | std::ios::binary);
+            damaged.write("garbage!garbage!", 16);
+        }
+        const std::size_t num_corrupt = cache.load("test_cache_a.txt", options, report).points.size();
+        std::cout << "cache: " << (cache.hit() ? "hit" : "miss") << " on a corrupt snapshot (expected miss), "
+            << num_corrupt << " points (expected 100)" << '\n';
+
+        // Room for two snapshots (of files with names and contents of the same size): a, b, a again, then c evicts b
+        Geo2Util::CacheOptions small_options = cache_options;
+        small_options.maxBytes = fs::file_size(snapshot) * 5 / 2;
+        Geo2Util::GeometryCache small_cache(small_options);
+        writeFile("test_cache_b.txt", 300);
+        writeFile("test_cache_c.txt", 400);
+        small_cache.load("test_cache_a.txt", options, report);
+        small_cache.load("test_cache_b.txt", options, report);
+        small_cache.load("test_cache_a.txt", options, report);
+        small_cache.load("test_cache_c.txt", options, report);
+        std::cout << "cache: snapshots of a/b/c " << fs::exists(small_cache.snapshotPath("test_cache_a.txt"))
+            << fs::exists(small_cache.snapshotPath("test_cache_b.txt")) << fs::exists(small_cache.snapshotPath("test_cache_c.txt"))
+            << " (expected 101)" << '\n';
+    }
+
+    {   // layer test: interleaved layers are written as blocks whose lengths are filled in on close, and read back
+        // one layer at a time (the other blocks skipped with a seek, or line by line if their length is missing)
+        Geo2Util::ExportWriter writer("test_layers.txt");
+        writer.write(Geo2Util::toString(Point_2(0, 0)));
+        writer.write(Geo2Util::toString(Point_2(1, 1)), "roads");
+        writer.write(Geo2Util::toString(Segment_2(Point_2(0, 0), Point_2(2, 2))), "rivers");
+        writer.write(Geo2Util::toString(Point_2(3, 3)), "roads");
+        writer.close();
+
+        Geo2Util::ParseReport report;
+        std::cout << "layers:";
+        for (const std::string& layer : Geo2Util::getLayers("test_layers.txt", report)) std::cout << " '" << layer << "'";
+        std::cout << " (expected '' 'roads' 'rivers')" << '\n';
+
+        auto countLayer = [](const std::string& filename, const std::string& layer, std::size_t& num_diagnostics) {
+            Geo2Util::ParseOptions options;
+            options.layers = { layer };
+            Geo2Util::ParseReport layer_report;
+            const Geo2Util::GeometrySet geometry = Geo2Util::getGeometry(filename, options, layer_report);
+            num_diagnostics += layer_report.diagnostics.size();
+            return std::to_string(geometry.points.size()) + "/" + std::to_string(geometry.segments.size());
+        };
+        std::size_t num_diagnostics = report.diagnostics.size();
+        std::cout << "layers: points/segments of '' " << countLayer("test_layers.txt", "", num_diagnostics)
+            << ", roads " << countLayer("test_layers.txt", "roads", num_diagnostics)
+            << ", rivers " << countLayer("test_layers.txt", "rivers", num_diagnostics)
+            << " (expected 1/0, 2/0, 0/1)" << '\n';
+
+        // The same file as if the writer had died before filling in the length of the first block
+        std::ifstream in("test_layers.txt");
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const std::size_t at = text.find('@');
+        text.replace(at, text.find(' ', at) - at, text.find(' ', at) - at, ' ');
+        std::ofstream("test_layers_open.txt") << text;
+        std::cout << "layers: without the first length, roads " << countLayer("test_layers_open.txt", "roads", num_diagnostics)
+            << ", rivers " << countLayer("test_layers_open.txt", "rivers", num_diagnostics)
+            << " (expected 2/0, 0/1), " << num_diagnostics << " diagnostics (expected 0)" << '\n';
+    }
+
+    {   // intersection test: the plane sweep visits the same pairs as testing all pairs
+        // (short segments on an integer grid, so that there are shared endpoints, collinear overlaps and verticals)
+        std::vector<Segment_2> segs;
+        std::srand(1);
+        for (int k = 0; k < 10000; ++k) {
+            const int x = std::rand() % 1000, y = std::rand() % 1000;
+            segs.push_back(Segment_2(Point_2(x, y), Point_2(x + std::rand() % 21 - 10, y + std::rand() % 21 - 10)));
+        }
+        std::set<std::pair<std::size_t, std::size_t>> expected;
+        for (std::size_t i = 0; i < segs.size(); ++i) {
+            for (std::size_t j = i + 1; j < segs.size(); ++j) {
+                if (CGAL::do_intersect(segs[i], segs[j])) expected.insert(std::make_pair(i, j));
+            }
+        }
+
+        Geo2Util::IntersectionOptions options;
+        options.ignoreSharedEndpoints = false;
+        options.threads = 2;
+        std::mutex mutex;
+        std::set<std::pair<std::size_t, std::size_t>> visited;
+        std::size_t duplicates = 0;
+        Geo2Util::forEachIntersection(segs, options, [&](unsigned, std::size_t i, std::size_t j, const Point_2&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!visited.insert(std::make_pair(i, j)).second) ++duplicates;
+        });
+        std::cout << "intersections: " << visited.size() << " pairs (expected " << expected.size() << "), "
+            << (visited == expected ? "same pairs" : "different pairs") << " (expected same pairs), "
+            << duplicates << " duplicates (expected 0)" << '\n';
+    }
+
+    {   // intersection test: a stack of long segments that do not cross
+        std::vector<Segment_2> segs;
+        for (int k = 0; k < 100000; ++k) segs.push_back(Segment_2(Point_2(0, k), Point_2(1000000, k)));
+        const auto start = std::chrono::steady_clock::now();
+        const std::size_t found = Geo2Util::forEachIntersection(segs, Geo2Util::IntersectionOptions(),
+            [](unsigned, std::size_t, std::size_t, const Point_2&) {});
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "stacked segments: " << found << " intersections (expected 0) in " << elapsed.count() << " s" << '\n';
+    }
 }